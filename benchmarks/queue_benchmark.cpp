@@ -1,17 +1,47 @@
+#include <algorithm>
+#include <array>
 #include <benchmark/benchmark.h>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <ctime>
+#include <memory>
+#include <numeric>
 #include <optional>
+#include <queue>
+#include <random>
+#include <semaphore>
+#include <span>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "queues/concurrentqueue.h"
+#include "queues/flat_combining_queue.h"
+#include "queues/intrusive_mpsc_queue.h"
 #include "queues/locking_queue.h"
 #include "queues/locking_queue_circular_buffer.h"
 #include "queues/locking_queue_shared_mutex.h"
+#include "queues/locking_queue_two_lock.h"
 
 #include "queues/lockfree_queue.h"
+#include "queues/lockfree_queue_dynamic.h"
 #include "queues/lockfree_queue_fixed.h"
+#include "queues/lockfree_queue_ms.h"
+#include "queues/lockfree_queue_unbounded.h"
+#include "queues/multi_priority_queue.h"
+#include "queues/multi_queue.h"
+#include "queues/multicast_ring.h"
+#include "queues/sharded_queue.h"
+#include "queues/spsc_queue.h"
+#include "queues/ticket_queue.h"
+#include "queues/work_stealing_pool.h"
 
+template <typename QUEUE>
 static void bm_queue_queue_spsc(benchmark::State &state) {
-  lockfree_queue<int> q;
+  QUEUE q(100000);
   const int N = state.range(0);
 
   for (auto _ : state) {
@@ -40,7 +70,35 @@ static void bm_queue_queue_spsc(benchmark::State &state) {
     producer.join();
   }
 }
-template <typename QUEUE> static void bm_queue_mpmc(benchmark::State &state) {
+// element of SIZE bytes, not default constructible
+template <std::size_t SIZE> struct payload {
+  explicit payload(int id) : id{id} {}
+  int id;
+  std::array<char, SIZE - sizeof(int)> bytes{};
+};
+// pointer + tag in 12 bytes, leaves room for lockfree_queue's full flag
+// in a 16 byte slot. std::pair<void *, std::uint64_t> does not, the
+// queues with per-slot sequences take it instead.
+struct __attribute__((packed)) tagged_ptr {
+  void *ptr;
+  std::uint32_t tag;
+};
+template <typename T> T make_item(int i) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    // longer than the small string buffer, so every item allocates
+    return std::string(32, static_cast<char>('a' + i % 26));
+  } else if constexpr (std::is_same_v<T, std::pair<void *, std::uint64_t>>) {
+    return {nullptr, static_cast<std::uint64_t>(i)};
+  } else if constexpr (std::is_same_v<T, tagged_ptr>) {
+    return {nullptr, static_cast<std::uint32_t>(i)};
+
+  } else {
+    return T(i);
+  }
+}
+
+template <typename QUEUE, typename T = int>
+static void bm_queue_mpmc(benchmark::State &state) {
   const int N = state.range(0);             // Number of items per producer
   const int num_producers = state.range(1); // Number of producer threads
   const int num_consumers = state.range(2); // Number of consumer threads
@@ -55,7 +113,8 @@ template <typename QUEUE> static void bm_queue_mpmc(benchmark::State &state) {
     for (int p = 0; p < num_producers; ++p) {
       producers.emplace_back([&]() {
         for (int i = 0; i < N; ++i) {
-          while (!q.try_put(i)) {
+          auto item{make_item<T>(i)};
+          while (!q.try_put(std::move(item))) {
             std::this_thread::yield();
           }
           produced_count.fetch_add(1, std::memory_order_relaxed);
@@ -92,10 +151,583 @@ template <typename QUEUE> static void bm_queue_mpmc(benchmark::State &state) {
       t.join();
   }
 }
+// Args: capacity. one producer puts 2^16 items with the blocking put
+// while a slow consumer spends 2us per item. reports the producer's
+// per-put latency percentiles (ns) and the share of items dropped.
+// with reject_newest the put waits for the consumer once the queue is
+// full, with overwrite_oldest it evicts instead.
+template <typename QUEUE>
+static void bm_queue_put_latency_slow_consumer(benchmark::State &state) {
+  using clock = std::chrono::steady_clock;
+  const int N = 1 << 16;
+  std::vector<std::int64_t> latencies;
+  std::size_t overruns = 0;
+  for (auto _ : state) {
+    QUEUE q(state.range(0));
+    std::atomic<bool> done{false};
+    std::thread consumer([&]() {
+      while (!done.load(std::memory_order_relaxed)) {
+        if (q.try_get()) {
+          const auto until = clock::now() + std::chrono::microseconds(2);
+          while (clock::now() < until) {
+          }
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+    const auto start = clock::now();
+    for (int i = 0; i < N; ++i) {
+      const auto t0 = clock::now();
+      q.put(i);
+      latencies.push_back(
+          std::chrono::nanoseconds(clock::now() - t0).count());
+    }
+    state.SetIterationTime(
+        std::chrono::duration<double>(clock::now() - start).count());
+    done = true;
+    consumer.join();
+    overruns += q.overruns();
+  }
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&](double p) {
+    return static_cast<double>(latencies[latencies.size() * p]);
+  };
+  state.counters["p50_ns"] = percentile(0.5);
+  state.counters["p99_ns"] = percentile(0.99);
+  state.counters["p999_ns"] = percentile(0.999);
+  state.counters["max_ns"] = latencies.back();
+  state.counters["dropped"] =
+      static_cast<double>(overruns) / (state.iterations() * N);
+}
+
+// lane count fixed at compile time, so it fits the QUEUE(size) benchmarks
+template <typename T, std::size_t LANES>
+struct multi_queue_lanes : multi_queue<T> {
+  multi_queue_lanes(size_t size) : multi_queue<T>(size, LANES) {}
+};
+
+// Args: N per producer, num_producers, num_consumers.
+// rank error of a get = items put before the returned one that are still
+// queued (0 for a strict fifo without concurrency). producers draw a
+// global put ticket right before try_put, consumers record the ticket
+// they got in get order. afterwards a fenwick tree over the put tickets
+// counts the older items not yet taken. the tickets serialize the
+// threads, use bm_queue_mpmc for throughput.
+template <typename QUEUE>
+static void bm_queue_rank_error(benchmark::State &state) {
+  const int N = state.range(0);
+  const int num_producers = state.range(1);
+  const int num_consumers = state.range(2);
+  const std::size_t total = static_cast<std::size_t>(N) * num_producers;
+
+  // rank 0, 1-3, 4-15, 16-63, 64-255, 256+
+  std::array<std::uint64_t, 6> histogram{};
+  std::vector<std::uint32_t> ranks;
+  for (auto _ : state) {
+    QUEUE q(N);
+    std::atomic<std::uint32_t> put_ticket{0};
+    std::atomic<std::uint32_t> get_ticket{0};
+    std::vector<std::uint32_t> order(total);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < num_producers; ++p) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i < N; ++i) {
+          const int item = put_ticket.fetch_add(1, std::memory_order_relaxed);
+          while (!q.try_put(item)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (int c = 0; c < num_consumers; ++c) {
+      threads.emplace_back([&]() {
+        while (get_ticket.load(std::memory_order_relaxed) < total) {
+          if (auto item = q.try_get()) {
+            order[get_ticket.fetch_add(1, std::memory_order_relaxed)] = *item;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (auto &t : threads)
+      t.join();
+
+    state.PauseTiming();
+    std::vector<std::uint32_t> taken(total + 1);
+    for (const auto ticket : order) {
+      std::uint32_t older_taken = 0;
+      for (auto i = ticket; i > 0; i -= i & -i)
+        older_taken += taken[i];
+      for (auto i = ticket + 1; i <= total; i += i & -i)
+        taken[i]++;
+      const auto rank = ticket - older_taken;
+      ranks.push_back(rank);
+      histogram[rank == 0 ? 0
+                          : std::min<std::size_t>(
+                                1 + (std::bit_width(rank) - 1) / 2, 5)]++;
+    }
+    state.ResumeTiming();
+  }
+
+  std::sort(ranks.begin(), ranks.end());
+  const auto count = static_cast<double>(ranks.size());
+  state.SetItemsProcessed(state.iterations() * total);
+  state.counters["rank_mean"] =
+      std::accumulate(ranks.begin(), ranks.end(), 0.0) / count;
+  state.counters["rank_p99"] = ranks[ranks.size() * 99 / 100];
+  state.counters["rank_max"] = ranks.back();
+  const std::array<const char *, 6> names{"h0",     "h1-3",    "h4-15",
+                                          "h16-63", "h64-255", "h256+"};
+  for (std::size_t i = 0; i < histogram.size(); i++)
+    state.counters[names[i]] = histogram[i] / count;
+}
+// same as bm_queue_mpmc, but full/empty waits back off with BACKOFF
+// instead of yielding (the queue is expected to use it for its CAS
+// retries too)
+template <typename QUEUE, typename BACKOFF>
+static void bm_queue_mpmc_backoff(benchmark::State &state) {
+  const int N = state.range(0);
+  const int num_producers = state.range(1);
+  const int num_consumers = state.range(2);
+
+  for (auto _ : state) {
+    QUEUE q(N);
+    std::atomic<int> consumed_count{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&]() {
+        for (int i = 0; i < N; ++i) {
+          retry_with<BACKOFF>([&] { return q.try_put(i); });
+        }
+      });
+    }
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < num_consumers; ++c) {
+      consumers.emplace_back([&]() {
+        BACKOFF backoff;
+        while (consumed_count.load(std::memory_order_relaxed) <
+               N * num_producers) {
+          if (q.try_get()) {
+            consumed_count.fetch_add(1, std::memory_order_relaxed);
+            backoff = BACKOFF{};
+          } else {
+            backoff.pause();
+          }
+        }
+      });
+    }
+
+    for (auto &t : producers)
+      t.join();
+    for (auto &t : consumers)
+      t.join();
+  }
+}
+// same as bm_queue_mpmc, but with the blocking put/get
+template <typename QUEUE>
+static void bm_queue_mpmc_blocking(benchmark::State &state) {
+  const int N = state.range(0);             // Number of items per producer
+  const int num_producers = state.range(1); // Number of producer threads
+  const int num_consumers = state.range(2); // Number of consumer threads
+  const int total = N * num_producers;
+
+  for (auto _ : state) {
+    QUEUE q(N);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&]() {
+        for (int i = 0; i < N; ++i) {
+          q.put(i);
+        }
+      });
+    }
+
+    // consumer 0 also takes the remainder
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < num_consumers; ++c) {
+      const int count =
+          total / num_consumers + (c == 0 ? total % num_consumers : 0);
+      consumers.emplace_back([&q, count]() {
+        for (int i = 0; i < count; ++i) {
+          benchmark::DoNotOptimize(q.get());
+        }
+      });
+    }
+
+    for (auto &t : producers)
+      t.join();
+    for (auto &t : consumers)
+      t.join();
+  }
+}
+// same as bm_queue_mpmc, but moves items in batches of state.range(3)
+template <typename QUEUE>
+static void bm_queue_mpmc_bulk(benchmark::State &state) {
+  const int N = state.range(0);             // Number of items per producer
+  const int num_producers = state.range(1); // Number of producer threads
+  const int num_consumers = state.range(2); // Number of consumer threads
+  const std::size_t batch = state.range(3); // Items per bulk call
+
+  for (auto _ : state) {
+    QUEUE q(N);
+    std::atomic<int> consumed_count{0};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&]() {
+        std::vector<int> buffer(batch);
+        for (int i = 0; i < N;) {
+          const auto count{std::min<std::size_t>(batch, N - i)};
+          std::iota(buffer.begin(), buffer.begin() + count, i);
+          std::span<const int> pending{buffer.data(), count};
+          while (!pending.empty()) {
+            const auto put{q.try_put_bulk(pending)};
+            if (put == 0) {
+              std::this_thread::yield();
+            }
+            pending = pending.subspan(put);
+          }
+          i += count;
+        }
+      });
+    }
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < num_consumers; ++c) {
+      consumers.emplace_back([&]() {
+        std::vector<int> buffer(batch);
+        while (true) {
+          const auto got{q.try_get_bulk(std::span<int>{buffer})};
+          if (got > 0) {
+            int count =
+                consumed_count.fetch_add(got, std::memory_order_relaxed) + got;
+            if (count >= N * num_producers) {
+              break;
+            }
+          } else {
+            if (consumed_count.load(std::memory_order_relaxed) >=
+                N * num_producers) {
+              break;
+            }
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+
+    for (auto &t : producers)
+      t.join();
+    for (auto &t : consumers)
+      t.join();
+  }
+  state.SetItemsProcessed(state.iterations() * N * num_producers);
+}
+// a consumer waits on an idle queue, after state.range(0) us of idle time the
+// main thread hands over one timestamp. the iteration time is the wakeup
+// latency, cpu_util is the process CPU time per wall time (~1 per spinner).
+template <typename QUEUE, bool BLOCKING>
+static void bm_queue_idle_wakeup(benchmark::State &state) {
+  using clock = std::chrono::steady_clock;
+  const auto idle = std::chrono::microseconds(state.range(0));
+  QUEUE q(1024);
+  std::atomic<double> latency{0.0};
+  std::binary_semaphore handled{0};
+
+  std::thread consumer([&]() {
+    while (true) {
+      std::int64_t sent{};
+      if constexpr (BLOCKING) {
+        sent = q.get();
+      } else {
+        std::optional<std::int64_t> opt;
+        while (!(opt = q.try_get())) {
+          std::this_thread::yield();
+        }
+        sent = *opt;
+      }
+      if (sent < 0)
+        break;
+      const auto received{clock::now().time_since_epoch().count()};
+      latency.store(std::chrono::duration<double>(clock::duration(
+                                                      received - sent))
+                        .count());
+      handled.release();
+    }
+  });
+
+  const auto cpu_start{std::clock()};
+  const auto wall_start{clock::now()};
+  for (auto _ : state) {
+    std::this_thread::sleep_for(idle);
+    while (!q.try_put(clock::now().time_since_epoch().count())) {
+    }
+    handled.acquire();
+    state.SetIterationTime(latency.load());
+  }
+  const auto cpu{double(std::clock() - cpu_start) / CLOCKS_PER_SEC};
+  const auto wall{std::chrono::duration<double>(clock::now() - wall_start)};
+  state.counters["cpu_util"] = cpu / wall.count();
+
+  while (!q.try_put(-1)) {
+  }
+  consumer.join();
+}
+// large record, trivially default constructible so reserve() skips zeroing
+template <std::size_t SIZE> struct record {
+  std::array<char, SIZE> bytes;
+};
+
+// 1 producer builds N records, 1 consumer reads a few bytes of each.
+// ZERO_COPY: records are built and read in place (reserve/commit,
+// peek/release), otherwise built on the stack and copied in and out.
+template <typename QUEUE, std::size_t SIZE, bool ZERO_COPY>
+static void bm_queue_zero_copy(benchmark::State &state) {
+  using T = record<SIZE>;
+  const int N = state.range(0);
+  QUEUE q(1024);
+
+  auto build = [](T &rec, int i) {
+    std::memset(rec.bytes.data(), static_cast<char>(i), SIZE);
+  };
+  auto consume = [](const T &rec) {
+    benchmark::DoNotOptimize(rec.bytes.front() + rec.bytes.back());
+  };
+
+  for (auto _ : state) {
+    std::thread producer([&]() {
+      for (int i = 0; i < N; ++i) {
+        if constexpr (ZERO_COPY) {
+          auto slot{q.try_reserve()};
+          while (!slot) {
+            std::this_thread::yield();
+            slot = q.try_reserve();
+          }
+          if constexpr (std::is_pointer_v<decltype(slot)>) {
+            build(*slot, i);
+            q.commit();
+          } else {
+            build(slot->value(), i);
+            q.commit(*slot);
+          }
+        } else {
+          T rec;
+          build(rec, i);
+          while (!q.try_put(rec)) {
+            std::this_thread::yield();
+          }
+        }
+      }
+    });
+
+    for (int consumed = 0; consumed < N;) {
+      if constexpr (ZERO_COPY) {
+        auto slot{q.try_peek()};
+        if (!slot) {
+          std::this_thread::yield();
+          continue;
+        }
+        if constexpr (std::is_pointer_v<decltype(slot)>) {
+          consume(*slot);
+          q.release();
+        } else {
+          consume(slot->value());
+          q.release(*slot);
+        }
+      } else {
+        auto opt{q.try_get()};
+        if (!opt) {
+          std::this_thread::yield();
+          continue;
+        }
+        consume(*opt);
+      }
+      ++consumed;
+    }
+    producer.join();
+  }
+  state.SetBytesProcessed(state.iterations() * N * SIZE);
+}
+// bursty load: the producer puts state.range(0) items as fast as it can,
+// then idles for state.range(1) us. the consumer drains continuously.
+// the main thread samples allocated_bytes() every 100 us and reports the
+// peak, the average over time and what is left after the last burst.
+template <typename QUEUE>
+static void bm_queue_bursty_footprint(benchmark::State &state) {
+  const int burst = state.range(0);
+  const auto idle = std::chrono::microseconds(state.range(1));
+  const int bursts = 20;
+
+  std::size_t peak_bytes{};
+  double sum_bytes{};
+  std::size_t samples{};
+  std::size_t idle_bytes{};
+  for (auto _ : state) {
+    QUEUE q(burst);
+    std::atomic<bool> done{false};
+
+    std::thread producer([&]() {
+      for (int b = 0; b < bursts; ++b) {
+        for (int i = 0; i < burst; ++i) {
+          while (!q.try_put(i)) {
+            std::this_thread::yield();
+          }
+        }
+        std::this_thread::sleep_for(idle);
+      }
+    });
+    std::thread consumer([&]() {
+      int consumed = 0;
+      while (consumed < burst * bursts) {
+        if (q.try_get()) {
+          ++consumed;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      // one more look at the empty queue lets it shrink
+      q.try_get();
+      done = true;
+    });
+
+    while (!done) {
+      const auto bytes{q.allocated_bytes()};
+      peak_bytes = std::max(peak_bytes, bytes);
+      sum_bytes += bytes;
+      samples++;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    producer.join();
+    consumer.join();
+    idle_bytes = q.allocated_bytes();
+  }
+  state.counters["peak_bytes"] = peak_bytes;
+  state.counters["avg_bytes"] = samples > 0 ? sum_bytes / samples : 0.0;
+  state.counters["idle_bytes"] = idle_bytes;
+  // what lockfree_queue_fixed<int> sized for the burst holds all the time
+  // (slot = sequence + int, padded to 16 bytes)
+  state.counters["fixed_bytes"] = burst * 2 * sizeof(std::size_t);
+}
+// 1 producer, state.range(1) independent consumers that each see all N
+// items: one multicast_ring vs. copying every item into one
+// lockfree_queue_fixed per consumer.
+static void bm_multicast_ring(benchmark::State &state) {
+  const int N = state.range(0);
+  const int consumers = state.range(1);
+
+  for (auto _ : state) {
+    multicast_ring<int> ring(1024);
+    std::vector<multicast_ring<int>::consumer_group *> groups;
+    for (int c = 0; c < consumers; ++c) {
+      groups.push_back(&ring.add_consumer_group());
+    }
+
+    std::vector<std::thread> threads;
+    for (auto *group : groups) {
+      threads.emplace_back([group, N]() {
+        std::int64_t sum = 0;
+        int seen = 0;
+        while (seen < N) {
+          seen += group->consume([&](int &item, std::int64_t) { sum += item; });
+        }
+        benchmark::DoNotOptimize(sum);
+      });
+    }
+    for (int i = 0; i < N; ++i) {
+      ring.put(i);
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * N * consumers);
+}
+static void bm_fanout_queues(benchmark::State &state) {
+  const int N = state.range(0);
+  const int consumers = state.range(1);
+
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<lockfree_queue_fixed<int>>> queues;
+    for (int c = 0; c < consumers; ++c) {
+      queues.push_back(std::make_unique<lockfree_queue_fixed<int>>(1024));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &q : queues) {
+      threads.emplace_back([&q = *q, N]() {
+        std::int64_t sum = 0;
+        int seen = 0;
+        while (seen < N) {
+          if (auto item = q.try_get()) {
+            sum += *item;
+            ++seen;
+          } else {
+            std::this_thread::yield();
+          }
+        }
+        benchmark::DoNotOptimize(sum);
+      });
+    }
+    for (int i = 0; i < N; ++i) {
+      for (auto &q : queues) {
+        while (!q->try_put(i)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * N * consumers);
+}
+// MPSC with intrusive nodes: every producer pushes its own N preallocated
+// messages, one consumer pops them all. same args as bm_queue_mpmc
+// (consumers must be 1).
+struct mpsc_message : mpsc_hook {
+  int value;
+};
+static void bm_queue_intrusive_mpsc(benchmark::State &state) {
+  const int N = state.range(0);
+  const int num_producers = state.range(1);
+  std::vector<std::vector<mpsc_message>> messages(
+      num_producers, std::vector<mpsc_message>(N));
+
+  for (auto _ : state) {
+    intrusive_mpsc_queue<mpsc_message> q;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&, p]() {
+        for (int i = 0; i < N; ++i) {
+          messages[p][i].value = i;
+          q.push(messages[p][i]);
+        }
+      });
+    }
+    std::int64_t sum = 0;
+    int consumed = 0;
+    while (consumed < N * num_producers) {
+      if (auto *msg = q.try_pop()) {
+        sum += msg->value;
+        ++consumed;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    for (auto &t : producers) {
+      t.join();
+    }
+  }
+}
 template <typename T> struct moodycamel_wrapper {
   moodycamel::ConcurrentQueue<T> q;
 
-  moodycamel_wrapper<T>(std::size_t size) : q(size) {}
+  moodycamel_wrapper(std::size_t size) : q(size) {}
   bool try_put(const T &val) { return q.try_enqueue(val); }
   std::optional<T> try_get() {
     T val;
@@ -108,8 +740,195 @@ template <typename T> struct moodycamel_wrapper {
   }
 };
 
+// std::priority_queue behind a mutex, the baseline for
+// multi_priority_queue
+template <typename PRIORITY, typename T> class locked_priority_queue {
+public:
+  using entry = std::pair<PRIORITY, T>;
+
+private:
+  struct later {
+    bool operator()(const entry &a, const entry &b) const {
+      return b.first < a.first;
+    }
+  };
+  std::priority_queue<entry, std::vector<entry>, later> q;
+  std::mutex mutex;
+
+public:
+  locked_priority_queue([[maybe_unused]] std::size_t size) {}
+  void push(PRIORITY priority, T value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    q.emplace(priority, std::move(value));
+  }
+  std::optional<entry> try_pop_min() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (q.empty())
+      return std::nullopt;
+    entry e{q.top()};
+    q.pop();
+    return e;
+  }
+  std::size_t try_pop_min_bulk(std::span<entry> out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t count{0};
+    for (; count < out.size() && !q.empty(); count++) {
+      out[count] = q.top();
+      q.pop();
+    }
+    return count;
+  }
+};
+
+// uniform: any 32 bit deadline. clustered: 8 narrow bands of 256
+// deadlines each, lots of ties
+template <bool CLUSTERED> std::uint64_t next_deadline(std::mt19937 &rng) {
+  if constexpr (CLUSTERED) {
+    return (std::uint64_t{rng() % 8} << 24) | (rng() % 256);
+  } else {
+    return rng();
+  }
+}
+
+// Args: threads. every thread pushes BATCH deadlines, then pops BATCH
+// (try_pop_min for 1, try_pop_min_bulk otherwise), 2^20 pushes in total.
+// the queue is prefilled with 2^16 entries so pops rarely find it empty.
+template <typename PQ, bool CLUSTERED, int BATCH>
+static void bm_priority_queue(benchmark::State &state) {
+  using entry = typename PQ::entry;
+  const int threads = state.range(0);
+  const int rounds = (1 << 20) / BATCH / threads;
+
+  PQ q(1 << 16);
+  std::mt19937 prefill_rng(42);
+  for (int i = 0; i < (1 << 16); i++)
+    q.push(next_deadline<CLUSTERED>(prefill_rng), i);
+
+  for (auto _ : state) {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back([&, t]() {
+        std::mt19937 rng(t);
+        std::array<entry, BATCH> batch;
+        for (int r = 0; r < rounds; r++) {
+          for (int i = 0; i < BATCH; i++)
+            q.push(next_deadline<CLUSTERED>(rng), i);
+          if constexpr (BATCH == 1) {
+            benchmark::DoNotOptimize(q.try_pop_min());
+          } else {
+            benchmark::DoNotOptimize(q.try_pop_min_bulk(batch));
+          }
+        }
+      });
+    }
+    for (auto &w : workers)
+      w.join();
+  }
+  state.SetItemsProcessed(state.iterations() * rounds * BATCH * threads);
+}
+
+// thread pool where all workers share one QUEUE of tasks, the baseline
+// for work_stealing_pool. same interface: submit, wait_until.
+template <typename QUEUE> class queue_pool {
+  using task = std::function<void()>;
+
+  QUEUE q;
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+
+  bool run_one() {
+    auto t = q.try_get();
+    if (!t) return false;
+    (**t)();
+    delete *t;
+    return true;
+  }
+
+ public:
+  queue_pool(std::size_t num_threads) : q(100000) {
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      threads.emplace_back([this]() {
+        while (!stop.load(std::memory_order::relaxed)) {
+          if (!run_one()) std::this_thread::yield();
+        }
+      });
+    }
+  }
+  ~queue_pool() {
+    stop = true;
+    for (auto &t : threads) t.join();
+  }
+  void submit(task f) {
+    auto *t = new task(std::move(f));
+    while (!q.try_put(t)) std::this_thread::yield();
+  }
+  template <typename PRED> void wait_until(PRED ready) {
+    while (!ready()) {
+      if (!run_one()) std::this_thread::yield();
+    }
+  }
+};
+
+// fork/join: fib(n - 1) is a task, fib(n - 2) runs inline, below cutoff
+// everything runs inline
+template <typename POOL>
+static std::int64_t fib_tasks(POOL &pool, int n, int cutoff) {
+  if (n < cutoff) {
+    return n < 2 ? n : fib_tasks(pool, n - 1, cutoff) + fib_tasks(pool, n - 2, cutoff);
+  }
+  std::int64_t a{};
+  std::atomic<bool> done{false};
+  pool.submit([&]() {
+    a = fib_tasks(pool, n - 1, cutoff);
+    done.store(true, std::memory_order::release);
+  });
+  const auto b = fib_tasks(pool, n - 2, cutoff);
+  pool.wait_until([&]() { return done.load(std::memory_order::acquire); });
+  return a + b;
+}
+// fork/join: split the range in halves down to chunk elements
+template <typename POOL>
+static std::int64_t sum_tasks(POOL &pool, const int *data, std::size_t n,
+                              std::size_t chunk) {
+  if (n <= chunk) return std::accumulate(data, data + n, std::int64_t{0});
+  const auto half = n / 2;
+  std::int64_t a{};
+  std::atomic<bool> done{false};
+  pool.submit([&]() {
+    a = sum_tasks(pool, data, half, chunk);
+    done.store(true, std::memory_order::release);
+  });
+  const auto b = sum_tasks(pool, data + half, n - half, chunk);
+  pool.wait_until([&]() { return done.load(std::memory_order::acquire); });
+  return a + b;
+}
+// Args: threads. fib(30) with tasks down to fib(12)
+template <typename POOL> static void bm_pool_fib(benchmark::State &state) {
+  POOL pool(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fib_tasks(pool, 30, 12));
+  }
+}
+// Args: threads. sum of 16M ints in chunks of 4096
+template <typename POOL> static void bm_pool_sum(benchmark::State &state) {
+  POOL pool(state.range(0));
+  std::vector<int> data(1 << 24);
+  std::iota(data.begin(), data.end(), 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sum_tasks(pool, data.data(), data.size(), 4096));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size() * sizeof(int));
+}
+
+// Args: N, producers = consumers from 1 to 24
+static void lock_sweep(benchmark::internal::Benchmark *b) {
+  for (int threads : {1, 2, 4, 8, 16, 24})
+    b->Args({100000, threads, threads});
+}
+
 // Register benchmarks
 // Args: N, num_producers, num_consumers
+// SPMC
 BENCHMARK(bm_queue_mpmc<lockfree_queue<int>>)
     ->ArgsProduct({
         {100000},            // N
@@ -124,6 +943,69 @@ BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int>>)
         {1, 2, 4, 8, 16, 24} // consumers
     })
     ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, padded_layout>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, padded_slots_layout>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, remapped_layout>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<ticket_queue<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_blocking<lockfree_queue_fixed<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_blocking<ticket_queue<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<sharded_queue<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_unbounded<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_ms<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
 BENCHMARK(bm_queue_mpmc<moodycamel_wrapper<int>>)
     ->ArgsProduct({
         {100000},            // N
@@ -138,6 +1020,20 @@ BENCHMARK(bm_queue_mpmc<locking_queue<int>>)
         {1, 2, 4, 8, 16, 24} // consumers
     })
     ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_two_lock<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<flat_combining_queue<int>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
 // BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<int>>)
 //     ->ArgsProduct({
 //        {100000},             // N
@@ -151,4 +1047,497 @@ BENCHMARK(bm_queue_mpmc<locking_queue_with_shared_mutex<int>>)
         {1, 2, 4, 8, 16, 24} // umers
     })
     ->Unit(benchmark::kMillisecond);
-BENCHMARK(bm_queue_queue_spsc)->Arg(1000000);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_shared_mutex<int, std::shared_mutex>>)
+    ->ArgsProduct({
+        {100000},            // N
+        {1},                 // producers
+        {1, 2, 4, 8, 16, 24} // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+// MPSC
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, padded_layout>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, padded_slots_layout>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int, remapped_layout>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<ticket_queue<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_blocking<lockfree_queue_fixed<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_blocking<ticket_queue<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<sharded_queue<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_unbounded<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_ms<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<moodycamel_wrapper<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_two_lock<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<flat_combining_queue<int>>)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_intrusive_mpsc)
+    ->ArgsProduct({
+        {100000},             // N
+        {1, 2, 4, 8, 16, 24}, // producers
+        {1}                   // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+// MPMC, high contention
+BENCHMARK(bm_queue_mpmc<flat_combining_queue<int>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue<int>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<int>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<multi_queue<int>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<multi_queue_lanes<int, 4>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<multi_queue_lanes<int, 64>>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+// relaxed vs strict fifo: throughput and rank error histogram
+BENCHMARK(bm_queue_rank_error<lockfree_queue_fixed<int>>)
+    ->ArgsProduct({{100000}, {1, 4, 8, 16}, {1, 4, 8, 16}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_queue_rank_error<multi_queue_lanes<int, 4>>)
+    ->ArgsProduct({{100000}, {1, 4, 8, 16}, {1, 4, 8, 16}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_queue_rank_error<multi_queue_lanes<int, 16>>)
+    ->ArgsProduct({{100000}, {1, 4, 8, 16}, {1, 4, 8, 16}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_queue_rank_error<multi_queue_lanes<int, 64>>)
+    ->ArgsProduct({{100000}, {1, 4, 8, 16}, {1, 4, 8, 16}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+// MPMC, lock policy sweep
+BENCHMARK(bm_queue_mpmc<locking_queue<int, std::mutex>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue<int, ttas_spinlock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue<int, ticket_lock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue<int, mcs_lock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<int, std::mutex>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<int, ttas_spinlock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<int, ticket_lock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<int, mcs_lock>>)
+    ->Apply(lock_sweep)
+    ->Unit(benchmark::kMillisecond);
+// MPMC, backoff policy sweep
+BENCHMARK(bm_queue_mpmc_backoff<
+              lockfree_queue_fixed<int, compact_layout, no_backoff>,
+              no_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              lockfree_queue_fixed<int, compact_layout, exponential_backoff>,
+              exponential_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              lockfree_queue_fixed<int, compact_layout, spin_yield_sleep_backoff>,
+              spin_yield_sleep_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<lockfree_queue<int, no_backoff>, no_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              lockfree_queue<int, exponential_backoff>,
+              exponential_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              lockfree_queue<int, spin_yield_sleep_backoff>,
+              spin_yield_sleep_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              locking_queue_with_shared_mutex<int, phase_fair_rwlock, no_backoff>,
+              no_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              locking_queue_with_shared_mutex<int, phase_fair_rwlock, exponential_backoff>,
+              exponential_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc_backoff<
+              locking_queue_with_shared_mutex<int, phase_fair_rwlock, spin_yield_sleep_backoff>,
+              spin_yield_sleep_backoff>)
+    ->Args({100000, 8, 8})
+    ->Args({100000, 16, 16})
+    ->Args({100000, 24, 24})
+    ->Unit(benchmark::kMillisecond);
+// payload sweep
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<std::string>, std::string>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<std::string>, std::string>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_shared_mutex<std::string>, std::string>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_ms<std::string>, std::string>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue<tagged_ptr>, tagged_ptr>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<std::pair<void *, std::uint64_t>>,
+                        std::pair<void *, std::uint64_t>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<payload<64>>, payload<64>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<payload<64>>, payload<64>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_shared_mutex<payload<64>>, payload<64>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<lockfree_queue_fixed<payload<256>>, payload<256>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_circular_buffer<payload<256>>, payload<256>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_mpmc<locking_queue_with_shared_mutex<payload<256>>, payload<256>>)
+    ->ArgsProduct({
+        {100000}, // N
+        {1, 4},   // producers
+        {1, 4}    // consumers
+    })
+    ->Unit(benchmark::kMillisecond);
+// Args: N, num_producers, num_consumers, batch size
+BENCHMARK(bm_queue_mpmc_bulk<lockfree_queue_fixed<int>>)
+    ->ArgsProduct({
+        {100000},                 // N
+        {1, 4},                   // producers
+        {1, 4},                   // consumers
+        {1, 8, 32, 64, 128, 256}  // batch size
+    })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// Args: N, copy vs. zero copy with large records
+BENCHMARK(bm_queue_zero_copy<lockfree_queue_fixed<record<1024>>, 1024, false>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<lockfree_queue_fixed<record<1024>>, 1024, true>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<lockfree_queue_fixed<record<4096>>, 4096, false>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<lockfree_queue_fixed<record<4096>>, 4096, true>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<spsc_queue<record<1024>>, 1024, false>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<spsc_queue<record<1024>>, 1024, true>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<spsc_queue<record<4096>>, 4096, false>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_zero_copy<spsc_queue<record<4096>>, 4096, true>)
+    ->Arg(100000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// Args: burst size, idle time between bursts in us
+BENCHMARK(bm_queue_bursty_footprint<lockfree_queue_dynamic<int>>)
+    ->ArgsProduct({
+        {10000, 100000}, // burst size
+        {1000, 10000}    // idle time
+    })
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// Args: idle time in us
+BENCHMARK(bm_queue_idle_wakeup<lockfree_queue_fixed<std::int64_t>, false>)
+    ->Arg(1000)
+    ->Iterations(200)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_queue_idle_wakeup<lockfree_queue_fixed<std::int64_t>, true>)
+    ->Arg(1000)
+    ->Iterations(200)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_queue_idle_wakeup<
+              locking_queue_with_circular_buffer<std::int64_t>, false>)
+    ->Arg(1000)
+    ->Iterations(200)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_queue_idle_wakeup<
+              locking_queue_with_circular_buffer<std::int64_t>, true>)
+    ->Arg(1000)
+    ->Iterations(200)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+// Args: capacity
+BENCHMARK(bm_queue_put_latency_slow_consumer<lockfree_queue_fixed<int>>)
+    ->Arg(1024)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_queue_put_latency_slow_consumer<lockfree_queue_fixed<
+              int, compact_layout, no_backoff, overwrite_oldest>>)
+    ->Arg(1024)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+// Args: N, independent consumers that each see every item
+BENCHMARK(bm_multicast_ring)
+    ->ArgsProduct({{1000000}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_fanout_queues)
+    ->ArgsProduct({{1000000}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Args: threads
+BENCHMARK(bm_pool_fib<work_stealing_pool>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_pool_fib<queue_pool<moodycamel_wrapper<std::function<void()> *>>>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_pool_fib<queue_pool<locking_queue<std::function<void()> *>>>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_pool_sum<work_stealing_pool>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_pool_sum<queue_pool<moodycamel_wrapper<std::function<void()> *>>>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_pool_sum<queue_pool<locking_queue<std::function<void()> *>>>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Args: threads
+BENCHMARK(bm_priority_queue<locked_priority_queue<std::uint64_t, int>, false, 1>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<locked_priority_queue<std::uint64_t, int>, false, 16>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<locked_priority_queue<std::uint64_t, int>, true, 1>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<locked_priority_queue<std::uint64_t, int>, true, 16>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<multi_priority_queue<std::uint64_t, int>, false, 1>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<multi_priority_queue<std::uint64_t, int>, false, 16>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<multi_priority_queue<std::uint64_t, int>, true, 1>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(bm_priority_queue<multi_priority_queue<std::uint64_t, int>, true, 16>)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(24)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// SPSC
+BENCHMARK(bm_queue_queue_spsc<spsc_queue<int>>)->Arg(1000000);
+BENCHMARK(bm_queue_queue_spsc<lockfree_queue_fixed<int>>)->Arg(1000000);
+BENCHMARK(bm_queue_queue_spsc<moodycamel_wrapper<int>>)->Arg(1000000);
+BENCHMARK(bm_queue_queue_spsc<lockfree_queue<int>>)->Arg(1000000);
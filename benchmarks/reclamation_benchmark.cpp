@@ -0,0 +1,119 @@
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+#include "queues/epoch_reclamation.h"
+#include "queues/hazard_pointers.h"
+
+struct reclaim_node {
+  std::int64_t value;
+  char data[56];
+};
+
+struct no_reclamation {};
+
+// the reader side of one operation: make a shared node safe to read,
+// read it, give it up again
+template <typename DOMAIN> struct reader_section;
+template <> struct reader_section<no_reclamation> {
+  static std::int64_t read(no_reclamation &,
+                           const std::atomic<reclaim_node *> &src) {
+    return src.load()->value;
+  }
+};
+template <> struct reader_section<epoch_domain> {
+  static std::int64_t read(epoch_domain &domain,
+                           const std::atomic<reclaim_node *> &src) {
+    epoch_domain::guard guard(domain);
+    return src.load()->value;
+  }
+};
+template <> struct reader_section<hazard_domain> {
+  static std::int64_t read(hazard_domain &domain,
+                           const std::atomic<reclaim_node *> &src) {
+    const auto value = domain.protect(0, src)->value;
+    domain.clear(0);
+    return value;
+  }
+};
+
+// cost of one protected read, all threads read the same node
+template <typename DOMAIN>
+static void bm_reclaim_read(benchmark::State &state) {
+  static DOMAIN domain;
+  static reclaim_node node{42, {}};
+  static std::atomic<reclaim_node *> shared{&node};
+
+  std::int64_t sum = 0;
+  for (auto _ : state) {
+    sum += reader_section<DOMAIN>::read(domain, shared);
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// cost of retiring a node (allocation included), reclamation amortized
+template <typename DOMAIN>
+static void bm_reclaim_retire(benchmark::State &state) {
+  static DOMAIN domain;
+  for (auto _ : state) {
+    domain.retire(new reclaim_node{});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// memory held back: a reader stalls while holding one node (inside a
+// critical section / with a hazard on it), the main thread retires
+// state.range(0) nodes. reports the bytes still waiting for reclamation.
+template <typename DOMAIN>
+static void bm_reclaim_stalled_reader(benchmark::State &state) {
+  const int N = state.range(0);
+  std::size_t held_back{};
+  for (auto _ : state) {
+    DOMAIN domain;
+    std::atomic<reclaim_node *> shared{new reclaim_node{}};
+    std::atomic<bool> holding{false}, leave{false};
+
+    std::thread reader([&]() {
+      if constexpr (std::is_same_v<DOMAIN, epoch_domain>) {
+        epoch_domain::guard guard(domain);
+        benchmark::DoNotOptimize(shared.load()->value);
+        holding = true;
+        while (!leave) std::this_thread::yield();
+      } else {
+        benchmark::DoNotOptimize(domain.protect(0, shared)->value);
+        holding = true;
+        while (!leave) std::this_thread::yield();
+        domain.clear(0);
+      }
+    });
+    while (!holding) std::this_thread::yield();
+
+    domain.retire(shared.exchange(nullptr));
+    for (int i = 0; i < N; ++i) {
+      domain.retire(new reclaim_node{});
+    }
+    held_back = domain.pending() * sizeof(reclaim_node);
+
+    leave = true;
+    reader.join();
+  }
+  state.counters["held_back_bytes"] = held_back;
+}
+
+BENCHMARK(bm_reclaim_read<no_reclamation>)->ThreadRange(1, 8);
+BENCHMARK(bm_reclaim_read<epoch_domain>)->ThreadRange(1, 8);
+BENCHMARK(bm_reclaim_read<hazard_domain>)->ThreadRange(1, 8);
+
+BENCHMARK(bm_reclaim_retire<epoch_domain>)->ThreadRange(1, 8);
+BENCHMARK(bm_reclaim_retire<hazard_domain>)->ThreadRange(1, 8);
+
+// Args: retired nodes while the reader stalls
+BENCHMARK(bm_reclaim_stalled_reader<epoch_domain>)
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(bm_reclaim_stalled_reader<hazard_domain>)
+    ->Arg(1000)->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
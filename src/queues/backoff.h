@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// backoff policies for retry loops: a failed CAS inside a queue, a
+// waiting spin lock, or a caller retrying try_put/try_get on a full or
+// empty queue. construct one per wait, call pause() after every failed
+// attempt.
+// no_backoff: retry at once (the old behaviour of the queues).
+// exponential_backoff: pause a random count in [limit/2, limit), limit
+// doubles up to spin_limit, then yield. the jitter keeps threads that
+// failed together from retrying together.
+// spin_yield_sleep_backoff: exponential pause, then yield, then sleep
+// with a doubling interval. gives the core away on long waits.
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+struct no_backoff {
+  void pause() {}
+};
+
+class exponential_backoff {
+private:
+  static constexpr std::uint32_t spin_limit{128};
+  std::uint32_t limit{2};
+
+  // xorshift32, per thread
+  static std::uint32_t next_random() {
+    thread_local std::uint32_t state{static_cast<std::uint32_t>(
+        reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1};
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+public:
+  void pause() {
+    if (limit > spin_limit) {
+      std::this_thread::yield();
+      return;
+    }
+    const auto spins{limit / 2 + next_random() % (limit / 2)};
+    for (std::uint32_t i{0}; i < spins; i++)
+      cpu_relax();
+    limit *= 2;
+  }
+};
+
+class spin_yield_sleep_backoff {
+private:
+  static constexpr std::uint32_t spin_steps{8};
+  static constexpr std::uint32_t yield_steps{16};
+  static constexpr std::chrono::microseconds max_sleep{1000};
+  std::uint32_t step{0};
+  std::chrono::microseconds sleep{20};
+
+public:
+  void pause() {
+    if (step < spin_steps) {
+      for (std::uint32_t i{0}; i < (std::uint32_t{1} << step); i++)
+        cpu_relax();
+    } else if (step < spin_steps + yield_steps) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(sleep);
+      sleep = std::min(sleep * 2, max_sleep);
+      return;
+    }
+    step++;
+  }
+};
+
+// for callers: repeat op (try_put/try_get/...) until its result converts
+// to true, pausing in between
+template <typename BACKOFF, typename OP> auto retry_with(OP &&op) {
+  BACKOFF backoff;
+  while (true) {
+    if (auto result{op()})
+      return result;
+    backoff.pause();
+  }
+}
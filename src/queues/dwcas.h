@@ -0,0 +1,35 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+
+// 16 byte compare-and-swap (cmpxchg16b on x86-64, needs -mcx16; casp or
+// ldxp/stxp on aarch64). has_dwcas is false where the compiler cannot
+// emit it inline, callers fall back to something else then.
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+inline constexpr bool has_dwcas{true};
+#else
+inline constexpr bool has_dwcas{false};
+#endif
+
+struct alignas(16) dwcas_word {
+  std::uint64_t lo{};
+  std::uint64_t hi{};
+
+  bool operator==(const dwcas_word &) const = default;
+};
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+// on failure expected receives the current value. there is no plain
+// 16 byte atomic load, dwcas(word, expected = x, x) is the load.
+inline bool dwcas(dwcas_word &target, dwcas_word &expected,
+                  const dwcas_word &desired) {
+  using u128 = unsigned __int128;
+  const auto old{std::bit_cast<u128>(expected)};
+  const auto current{__sync_val_compare_and_swap(
+      reinterpret_cast<u128 *>(&target), old, std::bit_cast<u128>(desired))};
+  if (current == old)
+    return true;
+  expected = std::bit_cast<dwcas_word>(current);
+  return false;
+}
+#endif
@@ -0,0 +1,219 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "queues/queue_layout.h"
+
+// epoch based reclamation (fraser 2004), the cheaper sibling of
+// hazard_domain: readers announce an epoch once per critical section
+// instead of once per node.
+// global epoch E. a thread inside a critical section (enter/exit or a
+// guard) announces the E it saw, outside it announces nothing.
+// retire:
+// the node is stamped with E and queued on the thread's own list.
+// advancing:
+// E can move to E + 1 once every thread inside a critical section
+// announced E. a node stamped r is unreachable for everybody once
+// E >= r + 2: whoever could still hold it announced r or r + 1 and
+// blocks the second step.
+// reclaiming is amortized: every batch_size retires the thread tries to
+// advance E and frees the front of its list that is old enough.
+// qsbr style use: stay inside a critical section and call quiescent()
+// at points where no node is held, that re-announces the current epoch.
+// threads register on first use, see hazard_domain for the record
+// lifetime rules (same here).
+class epoch_domain {
+public:
+  static constexpr std::size_t batch_size{64};
+
+private:
+  struct retired_node {
+    void *ptr;
+    void (*deleter)(void *);
+    std::uint64_t epoch;
+  };
+  struct record {
+    // (epoch << 1) | 1 inside a critical section, 0 outside
+    alignas(cache_line_size) std::atomic<std::uint64_t> announced{0};
+    std::atomic<bool> active{true};
+    std::atomic<std::size_t> pending{0};
+    record *next{};
+    // owner only
+    std::size_t nesting{};
+    std::size_t retires_since_reclaim{};
+    std::deque<retired_node> retired;
+  };
+  struct thread_records {
+    std::vector<std::pair<epoch_domain *, record *>> entries;
+    ~thread_records() {
+      for (auto &[domain, rec] : entries) {
+        domain->release_record(rec);
+      }
+    }
+  };
+
+  inline static thread_local thread_records local_records;
+
+  alignas(cache_line_size) std::atomic<std::uint64_t> _epoch{0};
+  alignas(cache_line_size) std::atomic<record *> _records{nullptr};
+  alignas(cache_line_size) std::atomic<bool> _has_orphans{false};
+  std::mutex orphan_mutex;
+  std::vector<retired_node> _orphans;
+
+  record *acquire_record() {
+    for (auto *rec{_records.load()}; rec != nullptr; rec = rec->next) {
+      auto active{false};
+      if (rec->active.compare_exchange_strong(active, true))
+        return rec;
+    }
+    auto *rec{new record};
+    rec->next = _records.load();
+    while (!_records.compare_exchange_weak(rec->next, rec)) {
+    }
+    return rec;
+  }
+  void release_record(record *rec) {
+    rec->nesting = 0;
+    rec->announced.store(0);
+    reclaim(*rec);
+    if (!rec->retired.empty()) {
+      std::unique_lock<std::mutex> lock(orphan_mutex);
+      _orphans.insert(_orphans.end(), rec->retired.begin(), rec->retired.end());
+      _has_orphans.store(true);
+      rec->retired.clear();
+      rec->pending.store(0, std::memory_order::relaxed);
+    }
+    rec->active.store(false);
+  }
+
+  record &local() {
+    for (auto &[domain, rec] : local_records.entries) {
+      if (domain == this)
+        return *rec;
+    }
+    auto *rec{acquire_record()};
+    local_records.entries.emplace_back(this, rec);
+    return *rec;
+  }
+
+  bool try_advance() {
+    auto epoch{_epoch.load()};
+    const auto current{(epoch << 1) | 1};
+    for (auto *rec{_records.load()}; rec != nullptr; rec = rec->next) {
+      const auto announced{rec->announced.load()};
+      if (announced != 0 && announced != current)
+        return false;
+    }
+    return _epoch.compare_exchange_strong(epoch, epoch + 1);
+  }
+
+  void reclaim(record &self) {
+    self.retires_since_reclaim = 0;
+    if (_has_orphans.load(std::memory_order::relaxed)) {
+      std::unique_lock<std::mutex> lock(orphan_mutex);
+      // orphans are older than anything we retire from now on
+      self.retired.insert(self.retired.begin(), _orphans.begin(),
+                          _orphans.end());
+      _orphans.clear();
+      _has_orphans.store(false);
+    }
+    try_advance();
+    const auto epoch{_epoch.load()};
+    while (!self.retired.empty() && self.retired.front().epoch + 2 <= epoch) {
+      const auto node{self.retired.front()};
+      self.retired.pop_front();
+      node.deleter(node.ptr);
+    }
+    self.pending.store(self.retired.size(), std::memory_order::relaxed);
+  }
+
+public:
+  // critical section as a scope
+  class guard {
+    epoch_domain *_domain;
+
+  public:
+    explicit guard(epoch_domain &domain) : _domain{&domain} {
+      _domain->enter();
+    }
+    guard(const guard &) = delete;
+    guard &operator=(const guard &) = delete;
+    ~guard() { _domain->exit(); }
+  };
+
+  epoch_domain() = default;
+  epoch_domain(const epoch_domain &) = delete;
+  epoch_domain &operator=(const epoch_domain &) = delete;
+  ~epoch_domain() {
+    std::erase_if(local_records.entries,
+                  [this](const auto &entry) { return entry.first == this; });
+    for (auto &node : _orphans) {
+      node.deleter(node.ptr);
+    }
+    for (auto *rec{_records.load()}; rec != nullptr;) {
+      for (auto &node : rec->retired) {
+        node.deleter(node.ptr);
+      }
+      delete std::exchange(rec, rec->next);
+    }
+  }
+
+  // registers the calling thread, optional (enter/retire do it on demand)
+  void register_thread() { local(); }
+
+  // critical sections nest, only the outermost one announces
+  void enter() {
+    auto &self{local()};
+    if (self.nesting++ == 0)
+      self.announced.store((_epoch.load() << 1) | 1);
+  }
+  void exit() {
+    auto &self{local()};
+    if (--self.nesting == 0)
+      self.announced.store(0, std::memory_order::release);
+  }
+  // qsbr: the calling thread holds no node right now
+  void quiescent() {
+    auto &self{local()};
+    if (self.nesting > 0)
+      self.announced.store((_epoch.load() << 1) | 1);
+  }
+
+  // ptr is unlinked, deleter(ptr) runs once no critical section can
+  // still reference it
+  void retire(void *ptr, void (*deleter)(void *)) {
+    auto &self{local()};
+    self.retired.push_back({ptr, deleter, _epoch.load()});
+    if (++self.retires_since_reclaim >= batch_size) {
+      reclaim(self);
+    } else {
+      self.pending.store(self.retired.size(), std::memory_order::relaxed);
+    }
+  }
+  template <typename T> void retire(T *ptr) {
+    retire(ptr, [](void *p) { delete static_cast<T *>(p); });
+  }
+  // runs an advance + reclaim round now
+  void reclaim() { reclaim(local()); }
+
+  std::uint64_t epoch() const { return _epoch.load(); }
+  // retired nodes not freed yet, over all threads (approximate)
+  std::size_t pending() const {
+    std::size_t total{};
+    for (auto *rec{_records.load()}; rec != nullptr; rec = rec->next) {
+      total += rec->pending.load(std::memory_order::relaxed);
+    }
+    return total;
+  }
+};
+
+// leaked on purpose, see default_hazard_domain
+inline epoch_domain &default_epoch_domain() {
+  static auto *domain{new epoch_domain};
+  return *domain;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// parking spot for threads waiting on a queue condition (not empty/not full).
+// waiter:
+// register in _waiters, re-check the condition under the mutex, sleep.
+// notifier:
+// after changing the queue state, load _waiters. nobody waiting: done,
+// so the fast path is a single load. otherwise take the mutex and wake all.
+// the waiter's increment and the notifier's state update must both be
+// seq_cst so that at least one of them sees the other (no lost wakeups).
+class event_count {
+private:
+  std::atomic<std::uint32_t> _waiters{0};
+  std::mutex mutex;
+  std::condition_variable cv;
+
+public:
+  void notify_all() {
+    if (_waiters.load(std::memory_order::seq_cst) == 0)
+      return;
+    { std::unique_lock<std::mutex> lock(mutex); }
+    cv.notify_all();
+  }
+
+  template <typename PRED> void wait(PRED ready) {
+    _waiters.fetch_add(1, std::memory_order::seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, ready);
+    }
+    _waiters.fetch_sub(1, std::memory_order::relaxed);
+  }
+
+  // returns ready() at wake up, false on timeout
+  template <typename PRED, typename CLOCK, typename DURATION>
+  bool wait_until(PRED ready,
+                  const std::chrono::time_point<CLOCK, DURATION> &deadline) {
+    _waiters.fetch_add(1, std::memory_order::seq_cst);
+    bool result{};
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      result = cv.wait_until(lock, deadline, ready);
+    }
+    _waiters.fetch_sub(1, std::memory_order::relaxed);
+    return result;
+  }
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// flat combining (hendler et al. 2010) around a sequential ring buffer.
+// every thread publishes its operation in a record on its own cache line
+// and waits. whoever gets the combiner lock applies all published
+// operations in one pass, so the ring, its indices and the lock stay in
+// one core's cache instead of bouncing between all of them.
+// records:
+// record_count of them, a thread starts at its home record (round robin
+// over threads) and claims the first free one with a CAS. with at most
+// record_count threads everybody keeps its own.
+// operation:
+// claim record, write arguments, state = request. then either take the
+// combiner lock and combine, or spin until the state says done (taking
+// the lock if it becomes free in the meantime).
+// combiner:
+// up to combine_passes sweeps over the records in use, executing every
+// request on the ring and storing the result before marking it done.
+template <typename T> class flat_combining_queue {
+public:
+  static constexpr std::size_t record_count{64};
+
+private:
+  static constexpr int combine_passes{2};
+
+  enum class op : int { idle, put_copy, put_move, get, done };
+
+  struct alignas(cache_line_size) record {
+    std::atomic<bool> owned{false};
+    std::atomic<op> state{op::idle};
+    const T *in{};
+    T *in_move{};
+    bool put_ok{};
+    std::optional<T> out;
+  };
+
+  std::size_t _max_size{};
+  std::unique_ptr<record[]> _records;
+  alignas(cache_line_size) std::atomic<std::size_t> _records_used{0};
+  alignas(cache_line_size) std::atomic<bool> combining{false};
+
+  // combiner only
+  alignas(cache_line_size) std::size_t _size{};
+  std::size_t read_idx{};
+  std::size_t write_idx{};
+  std::unique_ptr<slot_storage<T>[]> _data;
+
+  static std::size_t thread_idx() {
+    static std::atomic<std::size_t> next_thread_idx{0};
+    thread_local const std::size_t idx{
+        next_thread_idx.fetch_add(1, std::memory_order::relaxed)};
+    return idx;
+  }
+
+  record &claim_record() {
+    const auto home{thread_idx() % record_count};
+    for (std::size_t i{0};; i++) {
+      const auto idx{(home + i) % record_count};
+      auto &rec{_records[idx]};
+      auto owned{false};
+      if (!rec.owned.load(std::memory_order::relaxed) &&
+          rec.owned.compare_exchange_strong(owned, true,
+                                            std::memory_order::acquire)) {
+        auto used{_records_used.load(std::memory_order::relaxed)};
+        while (used <= idx && !_records_used.compare_exchange_weak(
+                                  used, idx + 1, std::memory_order::relaxed)) {
+        }
+        return rec;
+      }
+      if (i + 1 == record_count)
+        std::this_thread::yield();
+    }
+  }
+
+  void apply(record &rec, op request) {
+    switch (request) {
+    case op::put_copy:
+    case op::put_move:
+      rec.put_ok = _size < _max_size;
+      if (rec.put_ok) {
+        if (request == op::put_copy)
+          _data[write_idx].emplace(*rec.in);
+        else
+          _data[write_idx].emplace(std::move(*rec.in_move));
+        write_idx = (write_idx + 1) % _max_size;
+        _size++;
+      }
+      break;
+    case op::get:
+      if (_size > 0) {
+        rec.out.emplace(_data[read_idx].take());
+        read_idx = (read_idx + 1) % _max_size;
+        _size--;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  void combine() {
+    for (int pass{0}; pass < combine_passes; pass++) {
+      bool found{false};
+      const auto used{_records_used.load(std::memory_order::acquire)};
+      for (std::size_t i{0}; i < used; i++) {
+        auto &rec{_records[i]};
+        const auto request{rec.state.load(std::memory_order::acquire)};
+        if (request == op::idle || request == op::done)
+          continue;
+        apply(rec, request);
+        rec.state.store(op::done, std::memory_order::release);
+        found = true;
+      }
+      if (!found)
+        break;
+    }
+  }
+
+  void execute(record &rec, op request) {
+    rec.state.store(request, std::memory_order::release);
+    while (rec.state.load(std::memory_order::acquire) != op::done) {
+      if (!combining.load(std::memory_order::relaxed) &&
+          !combining.exchange(true, std::memory_order::acquire)) {
+        combine();
+        combining.store(false, std::memory_order::release);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void release(record &rec) {
+    rec.state.store(op::idle, std::memory_order::relaxed);
+    rec.owned.store(false, std::memory_order::release);
+  }
+
+public:
+  flat_combining_queue(size_t size = 100000)
+      : _max_size{std::max<size_t>(size, 1)},
+        _records{std::make_unique<record[]>(record_count)},
+        _data{std::make_unique<slot_storage<T>[]>(_max_size)} {}
+  ~flat_combining_queue() {
+    for (; _size > 0; _size--) {
+      _data[read_idx].destroy();
+      read_idx = (read_idx + 1) % _max_size;
+    }
+  }
+
+  bool try_put(const T &value) {
+    auto &rec{claim_record()};
+    rec.in = &value;
+    execute(rec, op::put_copy);
+    const auto ok{rec.put_ok};
+    release(rec);
+    return ok;
+  }
+  // value is only moved from on success
+  bool try_put(T &&value) {
+    auto &rec{claim_record()};
+    rec.in_move = &value;
+    execute(rec, op::put_move);
+    const auto ok{rec.put_ok};
+    release(rec);
+    return ok;
+  }
+
+  std::optional<T> try_get() {
+    auto &rec{claim_record()};
+    execute(rec, op::get);
+    std::optional<T> val{std::move(rec.out)};
+    rec.out.reset();
+    release(rec);
+    return val;
+  }
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "queues/queue_layout.h"
+
+// hazard pointers (michael 2004) for node based lock-free structures.
+// every thread owns a record with a few hazard slots. before touching a
+// node a thread publishes its address in a slot and re-reads the source,
+// so the node was still reachable after the hazard became visible.
+// unlinked nodes are retired into the thread's own list. once the list
+// holds twice as many nodes as there are hazard slots in the domain it is
+// scanned in one batch: collect all hazards, free every retired node that
+// is not among them. at least half the batch is freed, so the cost per
+// retired node stays constant.
+// records are claimed on first use and released when the thread exits,
+// what is left in its retired list goes to the domain's orphan list and
+// is picked up by the next scan. records are never freed before the
+// domain, so a domain must outlive the other threads that use it (the
+// default domain is never destroyed).
+class hazard_domain {
+public:
+  static constexpr std::size_t slots_per_thread{2};
+
+private:
+  struct retired_node {
+    void *ptr;
+    void (*deleter)(void *);
+  };
+  struct record {
+    std::array<std::atomic<void *>, slots_per_thread> hazards{};
+    alignas(cache_line_size) std::atomic<bool> active{true};
+    record *next{};
+    // owner only
+    std::vector<retired_node> retired;
+  };
+  struct thread_records {
+    std::vector<std::pair<hazard_domain *, record *>> entries;
+    ~thread_records() {
+      for (auto &[domain, rec] : entries) {
+        domain->release_record(rec);
+      }
+    }
+  };
+
+  inline static thread_local thread_records local_records;
+
+  std::atomic<record *> _records{nullptr};
+  std::atomic<std::size_t> _record_count{0};
+  alignas(cache_line_size) std::atomic<bool> _has_orphans{false};
+  std::mutex orphan_mutex;
+  std::vector<retired_node> _orphans;
+
+  record *acquire_record() {
+    for (auto *rec{_records.load()}; rec != nullptr; rec = rec->next) {
+      auto active{false};
+      if (rec->active.compare_exchange_strong(active, true))
+        return rec;
+    }
+    auto *rec{new record};
+    rec->next = _records.load();
+    while (!_records.compare_exchange_weak(rec->next, rec)) {
+    }
+    _record_count.fetch_add(1);
+    return rec;
+  }
+  void release_record(record *rec) {
+    for (auto &hazard : rec->hazards) {
+      hazard.store(nullptr);
+    }
+    scan(*rec);
+    if (!rec->retired.empty()) {
+      std::unique_lock<std::mutex> lock(orphan_mutex);
+      _orphans.insert(_orphans.end(), rec->retired.begin(), rec->retired.end());
+      _has_orphans.store(true);
+      rec->retired.clear();
+    }
+    rec->active.store(false);
+  }
+
+  record &local() {
+    for (auto &[domain, rec] : local_records.entries) {
+      if (domain == this)
+        return *rec;
+    }
+    auto *rec{acquire_record()};
+    local_records.entries.emplace_back(this, rec);
+    return *rec;
+  }
+
+  std::size_t batch_size() const {
+    return std::max<std::size_t>(
+        2 * slots_per_thread * _record_count.load(std::memory_order::relaxed),
+        64);
+  }
+
+  void scan(record &self) {
+    if (_has_orphans.load(std::memory_order::relaxed)) {
+      std::unique_lock<std::mutex> lock(orphan_mutex);
+      self.retired.insert(self.retired.end(), _orphans.begin(), _orphans.end());
+      _orphans.clear();
+      _has_orphans.store(false);
+    }
+    std::vector<void *> hazards;
+    for (auto *rec{_records.load()}; rec != nullptr; rec = rec->next) {
+      for (const auto &hazard : rec->hazards) {
+        if (auto *ptr{hazard.load()})
+          hazards.push_back(ptr);
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    std::erase_if(self.retired, [&](const retired_node &node) {
+      if (std::binary_search(hazards.begin(), hazards.end(), node.ptr))
+        return false;
+      node.deleter(node.ptr);
+      return true;
+    });
+  }
+
+public:
+  hazard_domain() = default;
+  hazard_domain(const hazard_domain &) = delete;
+  hazard_domain &operator=(const hazard_domain &) = delete;
+  ~hazard_domain() {
+    std::erase_if(local_records.entries,
+                  [this](const auto &entry) { return entry.first == this; });
+    for (auto &node : _orphans) {
+      node.deleter(node.ptr);
+    }
+    for (auto *rec{_records.load()}; rec != nullptr;) {
+      for (auto &node : rec->retired) {
+        node.deleter(node.ptr);
+      }
+      delete std::exchange(rec, rec->next);
+    }
+  }
+
+  // loads src into hazard slot until it is stable, returns the protected
+  // pointer (may be null)
+  template <typename T>
+  T *protect(std::size_t slot, const std::atomic<T *> &src) {
+    auto &hazard{local().hazards[slot]};
+    auto *ptr{src.load()};
+    while (true) {
+      hazard.store(ptr);
+      auto *current{src.load()};
+      if (current == ptr)
+        return ptr;
+      ptr = current;
+    }
+  }
+  void clear(std::size_t slot) {
+    local().hazards[slot].store(nullptr, std::memory_order::release);
+  }
+
+  // ptr is unlinked, delete it once no hazard points to it
+  template <typename T> void retire(T *ptr) {
+    auto &self{local()};
+    self.retired.push_back(
+        {ptr, [](void *p) { delete static_cast<T *>(p); }});
+    if (self.retired.size() >= batch_size())
+      scan(self);
+  }
+
+  // number of retired nodes of the calling thread not freed yet
+  std::size_t pending() { return local().retired.size(); }
+};
+
+// leaked on purpose: threads may still release their records during exit
+inline hazard_domain &default_hazard_domain() {
+  static auto *domain{new hazard_domain};
+  return *domain;
+}
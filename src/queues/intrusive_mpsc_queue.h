@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+
+#include "queues/queue_layout.h"
+
+// hook for intrusive_mpsc_queue, derive the element type from it.
+// copies start unlinked, the link belongs to the queue
+struct mpsc_hook {
+  std::atomic<mpsc_hook *> next{nullptr};
+
+  mpsc_hook() = default;
+  mpsc_hook(const mpsc_hook &) {}
+  mpsc_hook &operator=(const mpsc_hook &) { return *this; }
+};
+
+// vyukov intrusive mpsc queue: unbounded, never allocates, the links live
+// in the elements. the queue does not own them, an element must stay
+// alive (and must not be pushed again) until it was popped.
+// list from head (consumer) to tail (producers), with a stub node so it
+// is never empty.
+// push (any thread):
+// next = null, prev = tail.exchange(node), prev->next = node.
+// between the exchange and the last store the list is cut at prev, the
+// consumer sees an empty queue there until the producer finishes.
+// pop (one thread):
+// skip the stub, then hand out head if it has a successor. for the last
+// node the stub is pushed behind it first, so the node can be handed out
+// without the list running empty.
+template <typename T>
+  requires std::derived_from<T, mpsc_hook>
+class intrusive_mpsc_queue {
+private:
+  alignas(cache_line_size) std::atomic<mpsc_hook *> tail;
+  // consumer line
+  alignas(cache_line_size) mpsc_hook *head;
+  mpsc_hook stub;
+
+  void push_hook(mpsc_hook *hook) {
+    hook->next.store(nullptr, std::memory_order::relaxed);
+    auto *prev{tail.exchange(hook, std::memory_order::acq_rel)};
+    prev->next.store(hook, std::memory_order::release);
+  }
+
+public:
+  intrusive_mpsc_queue() : tail{&stub}, head{&stub} {}
+  intrusive_mpsc_queue(const intrusive_mpsc_queue &) = delete;
+  intrusive_mpsc_queue &operator=(const intrusive_mpsc_queue &) = delete;
+
+  void push(T &item) { push_hook(&item); }
+
+  // single consumer. nullptr when empty or when the newest push is not
+  // linked yet
+  T *try_pop() {
+    auto *first{head};
+    auto *next{first->next.load(std::memory_order::acquire)};
+    if (first == &stub) {
+      if (next == nullptr)
+        return nullptr;
+      head = next;
+      first = next;
+      next = next->next.load(std::memory_order::acquire);
+    }
+    if (next != nullptr) {
+      head = next;
+      return static_cast<T *>(first);
+    }
+    if (first != tail.load(std::memory_order::acquire))
+      return nullptr;
+    push_hook(&stub);
+    next = first->next.load(std::memory_order::acquire);
+    if (next == nullptr)
+      return nullptr;
+    head = next;
+    return static_cast<T *>(first);
+  }
+
+  // consumer side only, approximate while producers push
+  bool empty() const {
+    return head == &stub &&
+           stub.next.load(std::memory_order::acquire) == nullptr;
+  }
+};
@@ -1,71 +1,161 @@
+#pragma once
+#include <atomic>
+#include <bit>
 #include <cstddef>
-#include <iostream>
-#include <ostream>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
 #include <vector>
-#include <atomic>
-//write index, read index
-//circular buffer
+
+#include "queues/backoff.h"
+#include "queues/dwcas.h"
+// slots + occupancy bitmap (one bit per slot, 64 slots per word).
+// no order between slots, a put takes any free slot, a get any full one.
 // put:
-//  increase write
-//  write data
+//  find a word with a zero bit (countr_zero of ~word), claim the bit with
+//  fetch_or, write data
 // get:
-//  increase read
-//  read data
-template <typename T>
+//  find a word with a set bit, take the slot with a CAS (full -> empty),
+//  clear the bit
+// a set bit means the slot is owned by a producer (full or being
+// written) or still being emptied, so a full slot always has its bit set.
+// read_idx/write_idx only hint at the word where the last op succeeded.
+// slots:
+//  Node{val, empty} through atomic_ref. for 9-15 byte T that is not lock
+//  free, so where dwcas exists such T are packed into one 16 byte word
+//  instead (payload bytes, byte 15 = full, all zero = empty).
+//  anything that would need a lock does not compile.
+// BACKOFF (see backoff.h) paces retries after a lost bit or slot CAS.
+template <typename T, typename BACKOFF = no_backoff>
 class lockfree_queue {
  private:
+  static constexpr std::size_t bits{64};
+
   std::size_t size{};
-  std::size_t read_idx{};
-  std::size_t write_idx{};
+  std::size_t words{};
+  std::atomic<std::size_t> read_idx{};
+  std::atomic<std::size_t> write_idx{};
   struct Node {
     T val;
     bool empty = true;
   };
+  // atomic_ref needs more than Node's natural alignment
+  struct alignas(std::atomic_ref<Node>::required_alignment) node_slot {
+    Node node;
+  };
 
-  std::vector<Node> _data;
+  static constexpr bool packed{has_dwcas && std::is_trivially_copyable_v<T> &&
+                               sizeof(T) <= 15 &&
+                               !std::atomic_ref<Node>::is_always_lock_free};
+  using slot = std::conditional_t<packed, dwcas_word, node_slot>;
 
-  size_t calc_space(size_t read, size_t write) {
-    if (read == write)
-      return size;
-    if (read > write) {
-      return read - 1 - write;
+  std::vector<slot> _data;
+  std::vector<std::atomic<std::uint64_t>> occupied;
+
+  // the producer owns the bit, the slot is empty
+  static void fill(slot& s, const T& value) {
+    if constexpr (packed) {
+      dwcas_word desired{};
+      std::memcpy(static_cast<void*>(&desired), &value, sizeof(T));
+      reinterpret_cast<unsigned char*>(&desired)[15] = 1;
+      dwcas_word expected{};
+      dwcas(s, expected, desired);
+    } else {
+      std::atomic_ref<Node> ref{s.node};
+      ref.store(Node{value, false}, std::memory_order::release);
+    }
+  }
+  // empty: the producer that owns the bit is still writing, or another
+  // consumer was faster
+  static std::optional<T> take(slot& s) {
+    if constexpr (packed) {
+      dwcas_word expected{};
+      if (dwcas(s, expected, expected))
+        return std::nullopt;
+      BACKOFF backoff;
+      while (expected != dwcas_word{}) {
+        if (dwcas(s, expected, dwcas_word{})) {
+          T val;
+          std::memcpy(&val, &expected, sizeof(T));
+          return val;
+        }
+        backoff.pause();
+      }
+      return std::nullopt;
+    } else {
+      std::atomic_ref<Node> ref{s.node};
+      auto expected{ref.load(std::memory_order::acquire)};
+      // a failed CAS on a still full slot is retried, it can fail on
+      // padding bytes alone
+      BACKOFF backoff;
+      while (!expected.empty) {
+        if (ref.compare_exchange_strong(expected, Node{},
+                                        std::memory_order_acq_rel,
+                                        std::memory_order_acquire))
+          return {expected.val};
+        backoff.pause();
+      }
+      return std::nullopt;
     }
-    return size - write - 1;
   }
 
  public:
-  lockfree_queue(size_t size = 100000) : size{size}, _data(size, Node{}) {}
+  static constexpr bool is_lock_free{
+      packed || std::atomic_ref<Node>::is_always_lock_free};
+  static_assert(is_lock_free,
+                "T too large for a lock-free slot (up to 15 bytes with 16 "
+                "byte CAS, build with -mcx16 on x86-64)");
 
-  bool try_put(const T& value) {
-    Node desired{value, false};
-    for (size_t i{0}; i < size; i++) {
-      std::size_t curr_write_idx{(write_idx + i) % size};
-      std::atomic_ref<Node> ref{_data[curr_write_idx]};
-      auto expected{ref.load(std::memory_order::relaxed)};
+  lockfree_queue(size_t size = 100000)
+      : size{size},
+        words{(size + bits - 1) / bits},
+        _data(size),
+        occupied(words) {
+    // bits past the end look occupied to producers, consumers mask them
+    if (size % bits != 0)
+      occupied[words - 1].store(~std::uint64_t{0} << (size % bits));
+  }
 
-      if (expected.empty) {
-        if (ref.compare_exchange_weak(expected, desired,std::memory_order_release, std::memory_order_relaxed)) {
-          write_idx = curr_write_idx + 1;
-          return true;
+  bool try_put(const T& value) {
+    const auto start{write_idx.load(std::memory_order::relaxed)};
+    BACKOFF backoff;
+    for (size_t i{0}; i < words; i++) {
+      const auto w{(start + i) % words};
+      auto word{occupied[w].load(std::memory_order::relaxed)};
+      while (~word != 0) {
+        const auto bit{std::countr_zero(~word)};
+        const auto mask{std::uint64_t{1} << bit};
+        word = occupied[w].fetch_or(mask, std::memory_order::acquire);
+        if (word & mask) {
+          backoff.pause();
+          continue;
         }
+        fill(_data[w * bits + bit], value);
+        write_idx.store(w, std::memory_order::relaxed);
+        return true;
       }
     }
-    // std::cout << "queue is full or unlucky \n";
     return false;
   }
   std::optional<T> try_get() {
-    Node node{};
-    for (size_t i{0}; i < size; i++) {
-      std::size_t curr_read_idx{(read_idx + i) % size};
-      std::atomic_ref<Node> ref{_data[curr_read_idx]};
-      auto expected{ref.load(std::memory_order::relaxed)};
-
-      if (!expected.empty) {
-        // std::cout << std::format("attempt to read at idx {}\n", curr_read_idx);
-        if (ref.compare_exchange_weak(expected, node,std::memory_order_release, std::memory_order_relaxed)) {
-          read_idx = curr_read_idx + 1;
-          return {expected.val};
+    const auto start{read_idx.load(std::memory_order::relaxed)};
+    BACKOFF backoff;
+    for (size_t i{0}; i < words; i++) {
+      const auto w{(start + i) % words};
+      auto word{occupied[w].load(std::memory_order::relaxed)};
+      if (w == words - 1 && size % bits != 0)
+        word &= ~(~std::uint64_t{0} << (size % bits));
+      while (word != 0) {
+        const auto bit{std::countr_zero(word)};
+        word &= word - 1;
+        if (auto val{take(_data[w * bits + bit])}) {
+          occupied[w].fetch_and(~(std::uint64_t{1} << bit),
+                                std::memory_order::release);
+          read_idx.store(w, std::memory_order::relaxed);
+          return val;
         }
+        backoff.pause();
       }
     }
 
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// unbounded queue whose capacity follows the load.
+// same scheme as lockfree_queue_unbounded (linked segments, fetch_add
+// tickets, pinned + recycled segments), but the size of every new
+// segment is picked when it is appended:
+// - the segment that filled up is not the one readers are in (backlog
+//   spans several segments): double it, up to max_capacity.
+// - the segment was closed while idle: start over with min_capacity.
+// - otherwise: keep the size.
+// closing: a reader that finds a large segment empty (tail == head) moves
+// tail past the end with one fetch_add, so writers move on to a new
+// segment. end remembers the last ticket handed out before the close.
+// the reader then appends a min_capacity segment itself, so the large
+// buffer is released while the queue sits idle.
+//
+// reclamation:
+// segment control blocks are small and never freed before the queue,
+// only recycled, so late refcount updates always hit valid memory.
+// the slot buffers are freed when a retired segment is recycled (min
+// sized buffers are kept for reuse).
+template <typename T> class lockfree_queue_dynamic {
+  struct slot {
+    std::atomic<bool> ready{false};
+    slot_storage<T> storage;
+  };
+  struct segment {
+    alignas(cache_line_size) std::atomic<std::size_t> tail{0};
+    alignas(cache_line_size) std::atomic<std::size_t> head{0};
+    alignas(cache_line_size) std::atomic<std::size_t> refs{0};
+    std::atomic<bool> retired{false};
+    std::atomic<std::size_t> end{0};
+    std::atomic<segment *> next{nullptr};
+    std::size_t capacity{};
+    std::unique_ptr<slot[]> slots;
+  };
+
+private:
+  std::size_t _min_capacity{};
+  std::size_t _max_capacity{};
+
+  alignas(cache_line_size) std::atomic<segment *> head_seg;
+  alignas(cache_line_size) std::atomic<segment *> tail_seg;
+  alignas(cache_line_size) std::atomic<std::size_t> _allocated_bytes{0};
+
+  std::mutex pool_mutex;
+  std::vector<segment *> _pool;
+  std::vector<std::unique_ptr<segment>> _segments;
+
+  void resize(segment *seg, std::size_t capacity) {
+    if (seg->capacity == capacity)
+      return;
+    _allocated_bytes.fetch_sub(seg->capacity * sizeof(slot),
+                               std::memory_order::relaxed);
+    seg->slots = capacity > 0 ? std::make_unique<slot[]>(capacity) : nullptr;
+    seg->capacity = capacity;
+    _allocated_bytes.fetch_add(capacity * sizeof(slot),
+                               std::memory_order::relaxed);
+  }
+
+  segment *pool_get(std::size_t capacity) {
+    segment *seg{};
+    {
+      std::unique_lock<std::mutex> lock(pool_mutex);
+      if (_pool.empty()) {
+        _segments.push_back(std::make_unique<segment>());
+        seg = _segments.back().get();
+      } else {
+        seg = _pool.back();
+        _pool.pop_back();
+      }
+    }
+    resize(seg, capacity);
+    seg->end.store(capacity, std::memory_order::relaxed);
+    // reference held by the list
+    seg->refs.fetch_add(1);
+    return seg;
+  }
+  void pool_put(segment *seg) {
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    _pool.push_back(seg);
+  }
+
+  void recycle(segment *seg) {
+    seg->tail.store(0, std::memory_order::relaxed);
+    seg->head.store(0, std::memory_order::relaxed);
+    seg->next.store(nullptr, std::memory_order::relaxed);
+    if (seg->capacity == _min_capacity) {
+      for (std::size_t i{0}; i < seg->capacity; i++) {
+        seg->slots[i].ready.store(false, std::memory_order::relaxed);
+      }
+    } else {
+      resize(seg, 0);
+    }
+    pool_put(seg);
+  }
+
+  segment *acquire(std::atomic<segment *> &ptr) {
+    auto seg{ptr.load()};
+    while (true) {
+      seg->refs.fetch_add(1);
+      auto current{ptr.load()};
+      if (current == seg)
+        return seg;
+      release(seg);
+      seg = current;
+    }
+  }
+  void release(segment *seg) {
+    if (seg->refs.fetch_sub(1) == 1) {
+      auto retired{true};
+      if (seg->retired.compare_exchange_strong(retired, false))
+        recycle(seg);
+    }
+  }
+
+  std::size_t next_capacity(segment *seg) {
+    if (seg->end.load() < seg->capacity)
+      return _min_capacity;
+    if (head_seg.load() != seg)
+      return std::min(seg->capacity * 2, _max_capacity);
+    return seg->capacity;
+  }
+  // seg is full or closed: make sure it has a successor, move tail_seg on
+  segment *append(segment *seg) {
+    auto next{seg->next.load()};
+    if (next == nullptr) {
+      auto fresh{pool_get(next_capacity(seg))};
+      if (seg->next.compare_exchange_strong(next, fresh)) {
+        next = fresh;
+      } else {
+        fresh->refs.fetch_sub(1);
+        pool_put(fresh);
+      }
+    }
+    auto expected{seg};
+    tail_seg.compare_exchange_strong(expected, next);
+    return next;
+  }
+  // reader found seg empty at ticket
+  void close_if_large(segment *seg, std::size_t ticket) {
+    if (seg->capacity <= _min_capacity || seg->tail.load() != ticket)
+      return;
+    const auto last{seg->tail.fetch_add(seg->capacity)};
+    if (last < seg->capacity)
+      seg->end.store(last);
+  }
+
+public:
+  lockfree_queue_dynamic(size_t max_capacity = 100000,
+                         size_t min_capacity = 64)
+      : _min_capacity{std::max<size_t>(min_capacity, 1)},
+        _max_capacity{std::max(max_capacity, _min_capacity)} {
+    auto seg{pool_get(_min_capacity)};
+    head_seg.store(seg);
+    tail_seg.store(seg);
+  }
+  ~lockfree_queue_dynamic() {
+    for (auto seg{head_seg.load()}; seg != nullptr; seg = seg->next.load()) {
+      const auto last{std::min(seg->tail.load(), seg->end.load())};
+      for (auto idx{seg->head.load()}; idx < last; idx++) {
+        if (seg->slots[idx].ready.load())
+          seg->slots[idx].storage.destroy();
+      }
+    }
+  }
+
+  // bytes held by slot buffers, including the ones kept for reuse
+  std::size_t allocated_bytes() const {
+    return _allocated_bytes.load(std::memory_order::relaxed);
+  }
+
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    while (true) {
+      auto seg{acquire(tail_seg)};
+      const auto ticket{seg->tail.fetch_add(1)};
+      if (ticket < seg->capacity) {
+        auto &slot{seg->slots[ticket]};
+        slot.storage.emplace(std::forward<ARGS>(args)...);
+        slot.ready.store(true, std::memory_order_release);
+        release(seg);
+        return true;
+      }
+      append(seg);
+      release(seg);
+    }
+  }
+  bool try_put(const T &value) { return try_emplace(value); }
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  std::optional<T> try_get() {
+    while (true) {
+      auto seg{acquire(head_seg)};
+      auto local_head{seg->head.load(std::memory_order::relaxed)};
+      while (local_head < seg->end.load()) {
+        auto &slot{seg->slots[local_head]};
+        if (!slot.ready.load(std::memory_order_acquire)) {
+          close_if_large(seg, local_head);
+          if (local_head < seg->end.load()) {
+            release(seg);
+            return std::nullopt;
+          }
+          break;
+        }
+        if (seg->head.compare_exchange_weak(local_head, local_head + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+          std::optional<T> val{slot.storage.take()};
+          release(seg);
+          return val;
+        }
+      }
+
+      // every ticket of seg is read: move on, appending if writers have not
+      auto next{append(seg)};
+      auto expected{seg};
+      if (head_seg.compare_exchange_strong(expected, next)) {
+        seg->retired.store(true);
+        release(seg); // reference held by the list
+      }
+      release(seg);
+    }
+  }
+};
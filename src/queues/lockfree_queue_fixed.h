@@ -1,72 +1,421 @@
+#pragma once
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <memory>
+#include <optional>
+#include <span>
 #include <sys/resource.h>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "queues/backoff.h"
+#include "queues/event_count.h"
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
 // slot has an index and sequence num
-// atomic acquire_idx atomic read_idx
+// atomic read_idx atomic write_idx
 
+// slot i starts with sequence i (free for ticket i).
 // writer:
-// write_idx - read_idx >= size_: queue full
-// increment acquire_idx
-// when successful, write data to slot, set slot idx to writer idx
+// slot sequence < write_idx: slot still holds the previous lap, queue full
+// slot sequence == write_idx: try increase write_idx
+// when successful, construct data in slot, set sequence to write_idx + 1
 // reader:
-// read_idx < write_idx: no data
-// read_idx > slot_idx: data not ready yet.
-// fetch data, try increase idx, if succesful, return.
-template <typename T> class lockfree_queue_fixed {
-  struct slot {
-    std::atomic<std::size_t> sequence_idx;
-    T data;
+// slot sequence < read_idx + 1: no data (or data not ready yet)
+// slot sequence == read_idx + 1: try increase read_idx
+// when successful, move data out of slot, set sequence to read_idx + size
+// (free for the writer one lap later).
+// slots are uninitialized storage, a value only lives between write and read.
+//
+// bulk variants claim a contiguous range of tickets with a single CAS:
+// writer: claim min(n, free) slots, then publish each slot's sequence_idx.
+// reader: count consecutive published slots, claim them with one CAS,
+// then move them out.
+//
+// zero copy variants split writer and reader in two phases:
+// try_reserve claims the ticket, commit sets the sequence.
+// try_peek claims the ticket, release frees the slot.
+//
+// blocking variants spin on try_ a few times, then park on an event_count.
+// the index CAS are seq_cst so the parking handshake cannot miss an update.
+//
+// LAYOUT (see queue_layout.h) controls index/slot padding and remapping.
+// BACKOFF (see backoff.h) paces the retries after a lost index CAS.
+// FULL decides what a put does on a full queue:
+// reject_newest: fail (try_) or wait (blocking).
+// overwrite_oldest: lossy ring for metrics/traces, the producer does not
+// wait for slow consumers. its slot holds ticket write_idx - size, the
+// producer takes exactly that ticket from read_idx (CAS read_idx from it
+// to it + 1), destroys the value, frees the slot and retries its own
+// claim. overruns() counts the dropped entries, a consumer reports how
+// many it missed as the difference between two calls. if a reader already
+// holds that ticket (inside try_get, outstanding try_peek) or its writer
+// has not published it yet, nothing newer is dropped: the producer
+// yields and retries, after spin_tries the try_ put fails.
+struct reject_newest {};
+struct overwrite_oldest {};
+
+template <typename T, typename LAYOUT = compact_layout,
+          typename BACKOFF = no_backoff, typename FULL = reject_newest>
+class lockfree_queue_fixed {
+  using index_t = std::atomic<std::size_t>;
+
+  struct alignas(std::max({LAYOUT::slot_align, alignof(index_t),
+                           alignof(T)})) slot {
+    index_t sequence_idx;
+    slot_storage<T> storage;
   };
+  static constexpr std::size_t index_align{
+      std::max(LAYOUT::index_align, alignof(index_t))};
+  static constexpr std::size_t slots_per_line{
+      std::max<std::size_t>(cache_line_size / sizeof(slot), 1)};
 
 private:
+  // read-mostly, kept off the index lines
   std::size_t _size{};
-  std::atomic<std::size_t> read_idx;
-  std::atomic<std::size_t> write_idx;
-
+  std::size_t _lines{};
   std::unique_ptr<slot[]> _data;
 
-public:
-  lockfree_queue_fixed(size_t size = 100000)
-      : _size{size}, write_idx{size_t{0}}, read_idx{size_t{0}} {
-    _data = std::make_unique<slot[]>(size);
+  alignas(index_align) index_t read_idx;
+  alignas(index_align) index_t write_idx;
+
+  alignas(index_align) event_count not_empty;
+  alignas(index_align) event_count not_full;
+  alignas(index_align) std::atomic<std::size_t> _overruns{0};
+
+  slot &slot_at(std::size_t ticket) {
+    const auto idx{ticket % _size};
+    if constexpr (LAYOUT::remap) {
+      return _data[(idx % _lines) * slots_per_line + idx / _lines];
+    } else {
+      return _data[idx];
+    }
   }
 
-  bool try_put(const T &value) {
+  static constexpr int spin_tries{64};
 
-    auto local_write_idx{write_idx.load(std::memory_order::relaxed)};
-    do {
-      const auto local_read_idx{read_idx.load(std::memory_order::acquire)};
-      if (local_write_idx - local_read_idx >= _size)
-        return false;
-
-    } while (!write_idx.compare_exchange_weak(
-        local_write_idx, local_write_idx + 1, std::memory_order_release,
-        std::memory_order_relaxed));
-
-    auto &slot{_data[local_write_idx % _size]};
-    slot.data = value;
-    slot.sequence_idx.store(local_write_idx + 1, std::memory_order_release);
+  // 0: slot is free for ticket, < 0: still holds the previous lap,
+  // > 0: ticket was already taken by another writer
+  std::ptrdiff_t free_for(std::size_t ticket) {
+    return static_cast<std::ptrdiff_t>(
+        slot_at(ticket).sequence_idx.load(std::memory_order_acquire) - ticket);
+  }
+  // 0: slot holds the value of ticket, < 0: not written (yet),
+  // > 0: ticket was already taken by another reader
+  std::ptrdiff_t ready_for(std::size_t ticket) {
+    return static_cast<std::ptrdiff_t>(
+        slot_at(ticket).sequence_idx.load(std::memory_order_acquire) -
+        (ticket + 1));
+  }
+
+  bool has_data() const {
+    return write_idx.load(std::memory_order::seq_cst) !=
+           read_idx.load(std::memory_order::seq_cst);
+  }
+  bool has_space() const {
+    return write_idx.load(std::memory_order::seq_cst) -
+               read_idx.load(std::memory_order::seq_cst) <
+           _size;
+  }
+  static constexpr bool overwrite{std::is_same_v<FULL, overwrite_oldest>};
+
+  // full at ticket, drop the entry one lap older that holds its slot.
+  // false if that entry is still being written or a reader has it, the
+  // caller retries
+  bool evict_for(std::size_t ticket) {
+    auto oldest{ticket - _size};
+    if (ready_for(oldest) != 0 ||
+        !read_idx.compare_exchange_strong(oldest, oldest + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+      return false;
+    slot_at(oldest).storage.destroy();
+    free_slot(oldest);
+    _overruns.fetch_add(1, std::memory_order::relaxed);
     return true;
   }
-  std::optional<T> try_get() {
+
+  std::optional<std::size_t> claim_write() {
+    auto local_write_idx{write_idx.load(std::memory_order::relaxed)};
+    BACKOFF backoff;
+    [[maybe_unused]] int stalls{0};
+    while (true) {
+      const auto diff{free_for(local_write_idx)};
+      if (diff < 0) {
+        if constexpr (!overwrite) {
+          return std::nullopt;
+        } else {
+          if (!evict_for(local_write_idx)) {
+            if (++stalls == spin_tries)
+              return std::nullopt;
+            // the holder may be preempted
+            std::this_thread::yield();
+          }
+          local_write_idx = write_idx.load(std::memory_order::relaxed);
+          continue;
+        }
+      }
+      if (diff > 0) {
+        local_write_idx = write_idx.load(std::memory_order::relaxed);
+      } else if (write_idx.compare_exchange_weak(
+                     local_write_idx, local_write_idx + 1,
+                     std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return local_write_idx;
+      }
+      backoff.pause();
+    }
+  }
+  void publish(std::size_t ticket) {
+    slot_at(ticket).sequence_idx.store(ticket + 1, std::memory_order_release);
+    not_empty.notify_all();
+  }
+  std::optional<std::size_t> claim_read() {
     auto local_read_idx{read_idx.load(std::memory_order::relaxed)};
-    T val;
-    do {
-      auto &slot{_data[local_read_idx % _size]};
-      const auto local_sequence_idx =
-          slot.sequence_idx.load(std::memory_order_acquire);
-      if ((local_read_idx + 1) != local_sequence_idx) {
+    BACKOFF backoff;
+    while (true) {
+      const auto diff{ready_for(local_read_idx)};
+      if (diff < 0)
         return std::nullopt;
+      if (diff > 0) {
+        local_read_idx = read_idx.load(std::memory_order::relaxed);
+      } else if (read_idx.compare_exchange_weak(
+                     local_read_idx, local_read_idx + 1,
+                     std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return local_read_idx;
       }
+      backoff.pause();
+    }
+  }
+  void free_slot(std::size_t ticket) {
+    slot_at(ticket).sequence_idx.store(ticket + _size,
+                                       std::memory_order_release);
+    not_full.notify_all();
+  }
+
+  template <typename U> void put_impl(U &&value) {
+    for (int i{0}; i < spin_tries; i++) {
+      if (try_put(std::forward<U>(value)))
+        return;
+      std::this_thread::yield();
+    }
+    while (!try_put(std::forward<U>(value))) {
+      // overwrite_oldest: full is not the condition to wait for, only a
+      // reader or writer pinning the oldest slot
+      if constexpr (overwrite)
+        std::this_thread::yield();
+      else
+        not_full.wait([&] { return has_space(); });
+    }
+  }
 
-      val = slot.data;
+public:
+  // capacity is at least 2, sequence numbers of a lap must not collide
+  lockfree_queue_fixed(size_t size = 100000)
+      : _size{std::max<size_t>(size, 2)},
+        _lines{(_size + slots_per_line - 1) / slots_per_line},
+        read_idx{size_t{0}}, write_idx{size_t{0}} {
+    static_assert(!LAYOUT::pad_indices ||
+                      offsetof(lockfree_queue_fixed, _data) + sizeof(_data) <=
+                          offsetof(lockfree_queue_fixed, read_idx),
+                  "_data must not share a line with the indices");
+    _data = std::make_unique<slot[]>(LAYOUT::remap ? _lines * slots_per_line
+                                                   : _size);
+    for (std::size_t i{0}; i < _size; i++) {
+      slot_at(i).sequence_idx.store(i, std::memory_order::relaxed);
+    }
+  }
+  ~lockfree_queue_fixed() {
+    const auto local_write_idx{write_idx.load(std::memory_order::relaxed)};
+    for (auto idx{read_idx.load(std::memory_order::relaxed)};
+         idx != local_write_idx; idx++) {
+      auto &slot{slot_at(idx)};
+      if (slot.sequence_idx.load(std::memory_order::relaxed) == idx + 1)
+        slot.storage.destroy();
+    }
+  }
+
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    const auto ticket{claim_write()};
+    if (!ticket)
+      return false;
+    slot_at(*ticket).storage.emplace(std::forward<ARGS>(args)...);
+    publish(*ticket);
+    return true;
+  }
+  bool try_put(const T &value) { return try_emplace(value); }
+  // value is only moved from on success
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  std::optional<T> try_get() {
+    const auto ticket{claim_read()};
+    if (!ticket)
+      return std::nullopt;
+    std::optional<T> val{slot_at(*ticket).storage.take()};
+    free_slot(*ticket);
+    return val;
+  }
+
+  // zero copy: build the value in place, then publish it with commit.
+  // the value is default-initialized (no zeroing for trivial T).
+  // readers wait at an uncommitted reservation, so commit soon.
+  struct write_reservation {
+    T *slot_value;
+    std::size_t ticket;
+    T &value() const { return *slot_value; }
+  };
+  std::optional<write_reservation> try_reserve() {
+    const auto ticket{claim_write()};
+    if (!ticket)
+      return std::nullopt;
+    auto &storage{slot_at(*ticket).storage};
+    storage.default_construct();
+    return write_reservation{storage.get(), *ticket};
+  }
+  void commit(const write_reservation &reservation) {
+    publish(reservation.ticket);
+  }
+
+  // zero copy: read the value in place, release destroys it and frees the
+  // slot. writers wait at an unreleased slot, so release soon.
+  struct read_reservation {
+    T *slot_value;
+    std::size_t ticket;
+    T &value() const { return *slot_value; }
+  };
+  std::optional<read_reservation> try_peek() {
+    const auto ticket{claim_read()};
+    if (!ticket)
+      return std::nullopt;
+    return read_reservation{slot_at(*ticket).storage.get(), *ticket};
+  }
+  void release(const read_reservation &reservation) {
+    slot_at(reservation.ticket).storage.destroy();
+    free_slot(reservation.ticket);
+  }
+
+  void put(const T &value) { put_impl(value); }
+  void put(T &&value) { put_impl(std::move(value)); }
+  T get() {
+    for (int i{0}; i < spin_tries; i++) {
+      if (auto val{try_get()})
+        return std::move(*val);
+      std::this_thread::yield();
+    }
+    while (true) {
+      if (auto val{try_get()})
+        return std::move(*val);
+      // data may be claimed but not yet published, don't park on that
+      if (has_data()) {
+        std::this_thread::yield();
+        continue;
+      }
+      not_empty.wait([&] { return has_data(); });
+    }
+  }
+  template <typename REP, typename PERIOD>
+  std::optional<T> try_get_for(std::chrono::duration<REP, PERIOD> timeout) {
+    const auto deadline{std::chrono::steady_clock::now() + timeout};
+    for (int i{0}; i < spin_tries; i++) {
+      if (auto val{try_get()})
+        return val;
+      std::this_thread::yield();
+    }
+    while (true) {
+      if (auto val{try_get()})
+        return val;
+      if (has_data()) {
+        std::this_thread::yield();
+      } else if (!not_empty.wait_until([&] { return has_data(); }, deadline)) {
+        return try_get();
+      }
+      if (std::chrono::steady_clock::now() >= deadline)
+        return try_get();
+    }
+  }
+
+  // entries dropped by overwrite_oldest so far
+  std::size_t overruns() const {
+    return _overruns.load(std::memory_order::relaxed);
+  }
+
+  // returns the number of values actually enqueued (0 when full)
+  std::size_t try_put_bulk(std::span<const T> values) {
+    const auto max_count{std::min(values.size(), _size)};
+    if (max_count == 0)
+      return 0;
+    auto local_write_idx{write_idx.load(std::memory_order::relaxed)};
+    std::size_t count{};
+    BACKOFF backoff;
+    [[maybe_unused]] int stalls{0};
+    while (true) {
+      count = 0;
+      while (count < max_count && free_for(local_write_idx + count) == 0)
+        count++;
+      if (count == 0) {
+        // first slot still holds the previous lap: full
+        if (free_for(local_write_idx) < 0) {
+          if constexpr (!overwrite) {
+            return 0;
+          } else if (!evict_for(local_write_idx)) {
+            if (++stalls == spin_tries)
+              return 0;
+            std::this_thread::yield();
+          }
+        }
+        local_write_idx = write_idx.load(std::memory_order::relaxed);
+      } else if (write_idx.compare_exchange_weak(
+                     local_write_idx, local_write_idx + count,
+                     std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        break;
+      }
+      backoff.pause();
+    }
+
+    for (std::size_t i{0}; i < count; i++) {
+      auto &slot{slot_at(local_write_idx + i)};
+      slot.storage.emplace(values[i]);
+      slot.sequence_idx.store(local_write_idx + i + 1,
+                              std::memory_order_release);
+    }
+    not_empty.notify_all();
+    return count;
+  }
+
+  // returns the number of values moved to the front of out (0 when empty)
+  std::size_t try_get_bulk(std::span<T> out) {
+    const auto max_count{std::min(out.size(), _size)};
+    if (max_count == 0)
+      return 0;
+    auto local_read_idx{read_idx.load(std::memory_order::relaxed)};
+    std::size_t count{};
+    BACKOFF backoff;
+    while (true) {
+      count = 0;
+      while (count < max_count && ready_for(local_read_idx + count) == 0)
+        count++;
+      if (count == 0) {
+        if (ready_for(local_read_idx) < 0)
+          return 0;
+        local_read_idx = read_idx.load(std::memory_order::relaxed);
+      } else if (read_idx.compare_exchange_weak(
+                     local_read_idx, local_read_idx + count,
+                     std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        break;
+      }
+      backoff.pause();
+    }
 
-    } while (!read_idx.compare_exchange_weak(local_read_idx, local_read_idx + 1,
-                                             std::memory_order_release,
-                                             std::memory_order_relaxed));
-    return {val};
+    for (std::size_t i{0}; i < count; i++) {
+      auto &slot{slot_at(local_read_idx + i)};
+      out[i] = slot.storage.take();
+      slot.sequence_idx.store(local_read_idx + i + _size,
+                              std::memory_order_release);
+    }
+    not_full.notify_all();
+    return count;
   }
 };
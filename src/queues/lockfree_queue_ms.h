@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "queues/hazard_pointers.h"
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// michael-scott lock-free queue: linked list with a dummy node at the head,
+// unbounded, any T (one heap node per element).
+// writer:
+// new node, protect tail. tail->next null: CAS it to the node, then try to
+// swing tail (others help if we are slow). tail->next set: help swing tail.
+// reader:
+// protect head and head->next. next null -> empty. head == tail: tail lags,
+// help swing it. otherwise CAS head to next, next becomes the dummy and
+// the value is moved out of it, the old dummy is retired.
+// reclamation:
+// hazard pointers (hazard_pointers.h), slot 0 for head/tail, slot 1 for
+// next. the value is taken after the head CAS, which is safe because next
+// stays protected and no other reader touches the dummy's value.
+// size is ignored.
+template <typename T> class lockfree_queue_ms {
+  struct node {
+    std::atomic<node *> next{nullptr};
+    slot_storage<T> storage;
+  };
+
+private:
+  hazard_domain &_domain;
+  alignas(cache_line_size) std::atomic<node *> head;
+  alignas(cache_line_size) std::atomic<node *> tail;
+
+public:
+  lockfree_queue_ms([[maybe_unused]] size_t size = 100000,
+                    hazard_domain &domain = default_hazard_domain())
+      : _domain{domain} {
+    auto *dummy{new node};
+    head.store(dummy);
+    tail.store(dummy);
+  }
+  ~lockfree_queue_ms() {
+    auto *n{head.load()};
+    for (auto *next{n->next.load()}; next != nullptr; next = next->next.load()) {
+      next->storage.destroy();
+    }
+    while (n != nullptr) {
+      delete std::exchange(n, n->next.load());
+    }
+  }
+
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    auto *n{new node};
+    n->storage.emplace(std::forward<ARGS>(args)...);
+    while (true) {
+      auto *t{_domain.protect(0, tail)};
+      auto *next{t->next.load()};
+      if (t != tail.load())
+        continue;
+      if (next == nullptr) {
+        if (t->next.compare_exchange_strong(next, n)) {
+          tail.compare_exchange_strong(t, n);
+          break;
+        }
+      } else {
+        tail.compare_exchange_strong(t, next);
+      }
+    }
+    _domain.clear(0);
+    return true;
+  }
+  bool try_put(const T &value) { return try_emplace(value); }
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  std::optional<T> try_get() {
+    while (true) {
+      auto *h{_domain.protect(0, head)};
+      auto *t{tail.load()};
+      auto *next{_domain.protect(1, h->next)};
+      if (h != head.load())
+        continue;
+      if (next == nullptr) {
+        _domain.clear(0);
+        _domain.clear(1);
+        return std::nullopt;
+      }
+      if (h == t) {
+        tail.compare_exchange_strong(t, next);
+        continue;
+      }
+      if (head.compare_exchange_strong(h, next)) {
+        std::optional<T> val{next->storage.take()};
+        _domain.clear(0);
+        _domain.clear(1);
+        _domain.retire(h);
+        return val;
+      }
+    }
+  }
+};
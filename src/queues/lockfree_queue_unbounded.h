@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// linked list of fixed size segments, every slot of a segment is used once.
+// head_seg: oldest segment still read from, tail_seg: segment written to.
+//
+// writer:
+// fetch_add segment tail, if ticket < SEGMENT_SIZE write slot, mark ready.
+// else segment is closed: append a segment from the pool (CAS on next),
+// swing tail_seg forward, retry.
+// reader:
+// segment head < SEGMENT_SIZE: slot not ready -> empty (or writer busy),
+// otherwise claim it with a CAS on segment head and move the data out.
+// segment head == SEGMENT_SIZE: swing tail_seg and head_seg past it, retire.
+//
+// reclamation:
+// segments are never freed before the queue is destroyed, only recycled.
+// every access pins the segment (refs) and re-validates the global pointer.
+// the list holds one reference, dropped by the reader that retires the
+// segment. whoever drops refs to 0 on a retired segment recycles it.
+template <typename T, std::size_t SEGMENT_SIZE = 1024>
+class lockfree_queue_unbounded {
+  struct slot {
+    std::atomic<bool> ready{false};
+    // uninitialized, holds a value from the write until the read
+    slot_storage<T> storage;
+  };
+  struct segment {
+    alignas(cache_line_size) std::atomic<std::size_t> tail{0};
+    alignas(cache_line_size) std::atomic<std::size_t> head{0};
+    alignas(cache_line_size) std::atomic<std::size_t> refs{0};
+    std::atomic<bool> retired{false};
+    std::atomic<segment *> next{nullptr};
+    slot slots[SEGMENT_SIZE];
+  };
+
+private:
+  alignas(cache_line_size) std::atomic<segment *> head_seg;
+  alignas(cache_line_size) std::atomic<segment *> tail_seg;
+
+  std::mutex pool_mutex;
+  std::vector<segment *> _pool;
+  std::vector<std::unique_ptr<segment>> _segments;
+
+  segment *pool_get() {
+    segment *seg{};
+    {
+      std::unique_lock<std::mutex> lock(pool_mutex);
+      if (_pool.empty()) {
+        _segments.push_back(std::make_unique<segment>());
+        seg = _segments.back().get();
+      } else {
+        seg = _pool.back();
+        _pool.pop_back();
+      }
+    }
+    // reference held by the list
+    seg->refs.fetch_add(1);
+    return seg;
+  }
+  void pool_put(segment *seg) {
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    _pool.push_back(seg);
+  }
+
+  void recycle(segment *seg) {
+    seg->tail.store(0, std::memory_order::relaxed);
+    seg->head.store(0, std::memory_order::relaxed);
+    seg->next.store(nullptr, std::memory_order::relaxed);
+    for (auto &slot : seg->slots) {
+      slot.ready.store(false, std::memory_order::relaxed);
+    }
+    pool_put(seg);
+  }
+
+  segment *acquire(std::atomic<segment *> &ptr) {
+    auto seg{ptr.load()};
+    while (true) {
+      seg->refs.fetch_add(1);
+      auto current{ptr.load()};
+      if (current == seg)
+        return seg;
+      release(seg);
+      seg = current;
+    }
+  }
+  void release(segment *seg) {
+    if (seg->refs.fetch_sub(1) == 1) {
+      auto retired{true};
+      if (seg->retired.compare_exchange_strong(retired, false))
+        recycle(seg);
+    }
+  }
+
+public:
+  // size only pre-allocates segments, the queue grows beyond it
+  lockfree_queue_unbounded(size_t size = 100000) {
+    const auto segments{std::max<size_t>(size / SEGMENT_SIZE, 1)};
+    for (size_t i{0}; i < segments; i++) {
+      _segments.push_back(std::make_unique<segment>());
+      _pool.push_back(_segments.back().get());
+    }
+    auto seg{pool_get()};
+    head_seg.store(seg);
+    tail_seg.store(seg);
+  }
+  ~lockfree_queue_unbounded() {
+    for (auto seg{head_seg.load()}; seg != nullptr; seg = seg->next.load()) {
+      const auto last{std::min(seg->tail.load(), SEGMENT_SIZE)};
+      for (auto idx{seg->head.load()}; idx < last; idx++) {
+        if (seg->slots[idx].ready.load())
+          seg->slots[idx].storage.destroy();
+      }
+    }
+  }
+
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    while (true) {
+      auto seg{acquire(tail_seg)};
+      const auto ticket{seg->tail.fetch_add(1)};
+      if (ticket < SEGMENT_SIZE) {
+        auto &slot{seg->slots[ticket]};
+        slot.storage.emplace(std::forward<ARGS>(args)...);
+        slot.ready.store(true, std::memory_order_release);
+        release(seg);
+        return true;
+      }
+
+      auto next{seg->next.load()};
+      if (next == nullptr) {
+        auto fresh{pool_get()};
+        if (seg->next.compare_exchange_strong(next, fresh)) {
+          next = fresh;
+        } else {
+          fresh->refs.fetch_sub(1);
+          pool_put(fresh);
+        }
+      }
+      auto expected{seg};
+      tail_seg.compare_exchange_strong(expected, next);
+      release(seg);
+    }
+  }
+  bool try_put(const T &value) { return try_emplace(value); }
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  std::optional<T> try_get() {
+    while (true) {
+      auto seg{acquire(head_seg)};
+      auto local_head{seg->head.load(std::memory_order::relaxed)};
+      while (local_head < SEGMENT_SIZE) {
+        auto &slot{seg->slots[local_head]};
+        if (!slot.ready.load(std::memory_order_acquire)) {
+          release(seg);
+          return std::nullopt;
+        }
+        if (seg->head.compare_exchange_weak(local_head, local_head + 1,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+          std::optional<T> val{slot.storage.take()};
+          release(seg);
+          return val;
+        }
+      }
+
+      // every slot of seg is claimed by a reader, move on
+      auto next{seg->next.load()};
+      if (next == nullptr) {
+        release(seg);
+        return std::nullopt;
+      }
+      auto expected{seg};
+      tail_seg.compare_exchange_strong(expected, next);
+      expected = seg;
+      if (head_seg.compare_exchange_strong(expected, next)) {
+        seg->retired.store(true);
+        release(seg); // reference held by the list
+      }
+      release(seg);
+    }
+  }
+};
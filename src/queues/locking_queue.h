@@ -1,27 +1,32 @@
+#pragma once
 #include <cstddef>
 #include <mutex>
+#include <optional>
 #include <queue>
 
-template <typename T>
+#include "queues/locks.h"
+
+// LOCK: std::mutex or one of the spin locks in locks.h
+template <typename T, typename LOCK = std::mutex>
 class locking_queue {
  private:
   std::queue<T> _data;
-  std::mutex mutex;
+  LOCK mutex;
 
  public:
-  locking_queue([[maybe_unused]] size_t size) {}
+  locking_queue([[maybe_unused]] size_t size = 100000) {}
 
   bool try_put(const T& value) {
-    std::unique_lock<std::mutex> lock(mutex);
+    std::unique_lock<LOCK> lock(mutex);
 
     _data.push(value);
 
     return true;
   }
   std::optional<T> try_get() {
-    std::unique_lock<std::mutex> lock(mutex);
+    std::unique_lock<LOCK> lock(mutex);
     if (!_data.empty()) {
-      auto val = _data.back();
+      auto val = _data.front();
       _data.pop();
       return {val};
     }
@@ -1,10 +1,21 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <format>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <type_traits>
 #include <vector>
 
-template <typename T>
+#include "queues/locks.h"
+#include "queues/slot_storage.h"
+
+// LOCK: std::mutex or one of the spin locks in locks.h. anything but
+// std::mutex waits on a condition_variable_any.
+template <typename T, typename LOCK = std::mutex>
 class locking_queue_with_circular_buffer {
  private:
   std::size_t _max_size{};
@@ -13,35 +24,93 @@ class locking_queue_with_circular_buffer {
   std::size_t read_idx{};
   std::size_t write_idx{};
 
-  std::vector<T> _data;
-  std::mutex mutex;
+  // uninitialized, values only live between read_idx and write_idx
+  std::unique_ptr<slot_storage<T>[]> _data;
+  LOCK mutex;
+  using condition_variable =
+      std::conditional_t<std::is_same_v<LOCK, std::mutex>,
+                         std::condition_variable, std::condition_variable_any>;
+
+  // waiters are only counted under mutex, notify is skipped if nobody sleeps
+  condition_variable not_empty;
+  condition_variable not_full;
+  std::size_t get_waiters{};
+  std::size_t put_waiters{};
+
+  template <typename... ARGS>
+  void put_locked(ARGS&&... args) {
+    _data[write_idx].emplace(std::forward<ARGS>(args)...);
+    write_idx = (write_idx + 1) % _max_size;
+    _size++;
+    if (get_waiters > 0) not_empty.notify_one();
+  }
+  T get_locked() {
+    auto val = _data[read_idx].take();
+    read_idx = (read_idx + 1) % _max_size;
+    _size--;
+    if (put_waiters > 0) not_full.notify_one();
+    return val;
+  }
+  template <typename U>
+  void put_impl(U&& value) {
+    std::unique_lock<LOCK> lock(mutex);
+    put_waiters++;
+    not_full.wait(lock, [&] { return _size < _max_size; });
+    put_waiters--;
+    put_locked(std::forward<U>(value));
+  }
 
  public:
   locking_queue_with_circular_buffer(size_t size = 100000)
-      : _data(size, T{}), _max_size{size} {}
+      : _max_size{size}, _data(std::make_unique<slot_storage<T>[]>(size)) {}
+  ~locking_queue_with_circular_buffer() {
+    for (; _size > 0; _size--) {
+      _data[read_idx].destroy();
+      read_idx = (read_idx + 1) % _max_size;
+    }
+  }
 
-  bool try_put(const T& value) {
-    std::unique_lock<std::mutex> lock(mutex);
+  template <typename... ARGS>
+  bool try_emplace(ARGS&&... args) {
+    std::unique_lock<LOCK> lock(mutex);
      if (_size >=_max_size){
       return false;
      }
-    _data[write_idx] = value;
-    write_idx = (write_idx + 1) % _max_size;
-    _size++;
+    put_locked(std::forward<ARGS>(args)...);
     return true;
   }
+  bool try_put(const T& value) { return try_emplace(value); }
+  // value is only moved from on success
+  bool try_put(T&& value) { return try_emplace(std::move(value)); }
+
+  void put(const T& value) { put_impl(value); }
+  void put(T&& value) { put_impl(std::move(value)); }
 
   std::optional<T> try_get() {
-    std::unique_lock<std::mutex> lock(mutex);
+    std::unique_lock<LOCK> lock(mutex);
     if(_size <= 0) return std::nullopt;
     if (_size <= _max_size) {
-      const auto val = _data[read_idx];
-
-      read_idx = (read_idx + 1) % _max_size;
-      _size--;
-      return {val};
+      return {get_locked()};
     }
 
     return std::nullopt;
   }
+
+  T get() {
+    std::unique_lock<LOCK> lock(mutex);
+    get_waiters++;
+    not_empty.wait(lock, [&] { return _size > 0; });
+    get_waiters--;
+    return get_locked();
+  }
+
+  template <typename REP, typename PERIOD>
+  std::optional<T> try_get_for(std::chrono::duration<REP, PERIOD> timeout) {
+    std::unique_lock<LOCK> lock(mutex);
+    get_waiters++;
+    const bool ready{not_empty.wait_for(lock, timeout, [&] { return _size > 0; })};
+    get_waiters--;
+    if (!ready) return std::nullopt;
+    return {get_locked()};
+  }
 };
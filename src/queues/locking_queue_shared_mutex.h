@@ -1,47 +1,72 @@
+#pragma once
 #include <atomic>
 #include <cstddef>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <ostream>
 #include <shared_mutex>
 #include <vector>
 
-template <typename T> class locking_queue_with_shared_mutex {
+#include "queues/backoff.h"
+#include "queues/locks.h"
+#include "queues/slot_storage.h"
+
+// writers take the lock exclusively, readers shared and claim a slot with
+// a CAS on read_idx. LOCK defaults to phase_fair_rwlock: with
+// std::shared_mutex the readers keep the lock in shared mode and the
+// writer starves. BACKOFF (see backoff.h) paces the read_idx CAS retries.
+template <typename T, typename LOCK = phase_fair_rwlock,
+          typename BACKOFF = no_backoff>
+class locking_queue_with_shared_mutex {
 private:
   std::size_t _size{};
   std::atomic<std::size_t> read_idx;
   std::size_t write_idx;
 
-  std::vector<T> _data;
-  std::shared_mutex mutex;
+  // uninitialized, values only live between read_idx and write_idx
+  std::unique_ptr<slot_storage<T>[]> _data;
+  LOCK mutex;
 
 public:
   locking_queue_with_shared_mutex(size_t size = 100000)
-      : _data(size, T{}), _size{size}, write_idx{size_t{0}},
-        read_idx{size_t{0}} {}
+      : _size{size}, read_idx{size_t{0}}, write_idx{size_t{0}},
+        _data(std::make_unique<slot_storage<T>[]>(size)) {}
+  ~locking_queue_with_shared_mutex() {
+    for (auto idx{read_idx.load()}; idx < write_idx; idx++) {
+      _data[idx % _size].destroy();
+    }
+  }
 
-  bool try_put(const T &value) {
-    std::unique_lock<std::shared_mutex> lock(mutex);
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    std::unique_lock<LOCK> lock(mutex);
     auto local_read_idx{read_idx.load(std::memory_order::acquire)};
     if (write_idx - local_read_idx >= _size)
       return false;
-    _data[write_idx % _size] = value;
+    _data[write_idx % _size].emplace(std::forward<ARGS>(args)...);
     write_idx++;
     return true;
   }
+  bool try_put(const T &value) { return try_emplace(value); }
+  // value is only moved from on success
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  // readers claim an index first and move the value out afterwards,
+  // the writer cannot reuse the slot while the shared lock is held.
   std::optional<T> try_get() {
-    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::shared_lock<LOCK> lock(mutex);
     auto local_read_idx{read_idx.load(std::memory_order::acquire)};
-    T val;
-    do {
+    BACKOFF backoff;
+    while (true) {
       if (local_read_idx >= write_idx) {
         return std::nullopt;
       }
-
-      val = _data[local_read_idx % _size];
-
-    } while (!read_idx.compare_exchange_weak(local_read_idx, local_read_idx + 1,
-                                            std::memory_order_release,
-                                            std::memory_order_relaxed));
-    return {val};
+      if (read_idx.compare_exchange_weak(local_read_idx, local_read_idx + 1,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed))
+        break;
+      backoff.pause();
+    }
+    return {_data[local_read_idx % _size].take()};
   }
 };
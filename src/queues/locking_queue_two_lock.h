@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "queues/locks.h"
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// michael-scott two-lock queue: linked list with a dummy node at the head,
+// producers only take tail_mutex, consumers only take head_mutex, so one
+// producer and one consumer never contend.
+// writer (tail lock):
+// take a node from the free list, fill it, link it after tail, move tail.
+// reader (head lock):
+// head->next null -> empty. otherwise move the value out of head->next,
+// which becomes the new dummy, the old dummy goes to the free list.
+// free list:
+// treiber stack. pushes happen under the head lock, pops under the tail
+// lock, so there is at most one pusher and one popper at any time: a node
+// cannot be popped and pushed back while a pop is in flight (no ABA).
+// new is only called while the free list is empty.
+// unbounded, size is ignored. LOCK: std::mutex or a lock from locks.h
+template <typename T, typename LOCK = std::mutex> class locking_queue_two_lock {
+  struct node {
+    std::atomic<node *> next{nullptr};
+    slot_storage<T> storage;
+  };
+
+private:
+  alignas(cache_line_size) LOCK head_mutex;
+  node *head;
+
+  alignas(cache_line_size) LOCK tail_mutex;
+  node *tail;
+
+  alignas(cache_line_size) std::atomic<node *> free_list{nullptr};
+
+  // tail lock held
+  node *pool_get() {
+    auto *n{free_list.load(std::memory_order::acquire)};
+    while (n != nullptr &&
+           !free_list.compare_exchange_weak(
+               n, n->next.load(std::memory_order::relaxed),
+               std::memory_order::acquire, std::memory_order::acquire)) {
+    }
+    if (n == nullptr)
+      return new node;
+    n->next.store(nullptr, std::memory_order::relaxed);
+    return n;
+  }
+  // head lock held
+  void pool_put(node *n) {
+    auto *top{free_list.load(std::memory_order::relaxed)};
+    do {
+      n->next.store(top, std::memory_order::relaxed);
+    } while (!free_list.compare_exchange_weak(top, n,
+                                              std::memory_order::release,
+                                              std::memory_order::relaxed));
+  }
+
+public:
+  locking_queue_two_lock([[maybe_unused]] size_t size = 100000)
+      : head{new node}, tail{head} {}
+  ~locking_queue_two_lock() {
+    for (auto *n{head->next.load()}; n != nullptr; n = n->next.load()) {
+      n->storage.destroy();
+    }
+    while (head != nullptr) {
+      delete std::exchange(head, head->next.load());
+    }
+    for (auto *n{free_list.load()}; n != nullptr;) {
+      delete std::exchange(n, n->next.load());
+    }
+  }
+
+  template <typename... ARGS> bool try_emplace(ARGS &&...args) {
+    std::unique_lock<LOCK> lock(tail_mutex);
+    auto *n{pool_get()};
+    n->storage.emplace(std::forward<ARGS>(args)...);
+    tail->next.store(n, std::memory_order::release);
+    tail = n;
+    return true;
+  }
+  bool try_put(const T &value) { return try_emplace(value); }
+  bool try_put(T &&value) { return try_emplace(std::move(value)); }
+
+  std::optional<T> try_get() {
+    std::unique_lock<LOCK> lock(head_mutex);
+    auto *next{head->next.load(std::memory_order::acquire)};
+    if (next == nullptr)
+      return std::nullopt;
+    std::optional<T> val{next->storage.take()};
+    pool_put(std::exchange(head, next));
+    return val;
+  }
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <thread>
+
+#include "queues/backoff.h"
+#include "queues/queue_layout.h"
+
+// spin locks for the locking queues, drop-in for std::mutex (lock,
+// try_lock, unlock). they never enter the kernel, a waiter backs off
+// with exponential_backoff (pause, then yield once the wait gets long),
+// so a preempted holder does not burn a whole time slice of every waiter.
+
+// test and test-and-set: waiters spin on a plain load, so the line stays
+// shared until the holder releases it.
+class ttas_spinlock {
+private:
+  std::atomic<bool> locked{false};
+
+public:
+  void lock() {
+    exponential_backoff backoff;
+    while (locked.exchange(true, std::memory_order::acquire)) {
+      while (locked.load(std::memory_order::relaxed))
+        backoff.pause();
+    }
+  }
+  bool try_lock() {
+    return !locked.load(std::memory_order::relaxed) &&
+           !locked.exchange(true, std::memory_order::acquire);
+  }
+  void unlock() { locked.store(false, std::memory_order::release); }
+};
+
+// fifo: take a ticket, wait until it is served. next_ticket is on its
+// own line so arriving threads do not invalidate the line waiters spin on.
+class ticket_lock {
+private:
+  alignas(cache_line_size) std::atomic<std::uint32_t> next_ticket{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> now_serving{0};
+
+public:
+  void lock() {
+    const auto ticket{next_ticket.fetch_add(1, std::memory_order::relaxed)};
+    exponential_backoff backoff;
+    while (now_serving.load(std::memory_order::acquire) != ticket)
+      backoff.pause();
+  }
+  bool try_lock() {
+    auto ticket{now_serving.load(std::memory_order::acquire)};
+    return next_ticket.compare_exchange_strong(ticket, ticket + 1,
+                                               std::memory_order::acquire,
+                                               std::memory_order::relaxed);
+  }
+  // only the holder writes now_serving
+  void unlock() {
+    now_serving.store(now_serving.load(std::memory_order::relaxed) + 1,
+                      std::memory_order::release);
+  }
+};
+
+// mellor-crummey/scott queue lock: fifo, every waiter spins on its own
+// node, a release touches only the successor's line.
+// lock: node.next = null, prev = tail.exchange(node). prev set -> link
+// behind it and spin on node.locked.
+// unlock: no successor linked yet -> CAS tail back to null. if that fails
+// a successor is between its exchange and its link, wait for the link,
+// then clear its locked flag.
+// nodes come from a small per-thread pool (a thread can hold up to
+// max_held mcs locks at once, in any order). the holder's node is kept
+// in the lock, so it works with unique_lock and condition_variable_any.
+class mcs_lock {
+public:
+  static constexpr std::size_t max_held{8};
+
+private:
+  struct alignas(cache_line_size) node {
+    std::atomic<node *> next{nullptr};
+    std::atomic<bool> locked{false};
+    bool in_use{};
+  };
+
+  alignas(cache_line_size) std::atomic<node *> tail{nullptr};
+  // written by the holder only
+  node *owner{};
+
+  static node &acquire_node() {
+    thread_local std::array<node, max_held> nodes;
+    for (auto &n : nodes) {
+      if (!n.in_use) {
+        n.in_use = true;
+        n.next.store(nullptr, std::memory_order::relaxed);
+        return n;
+      }
+    }
+    std::terminate();
+  }
+
+public:
+  void lock() {
+    auto &n{acquire_node()};
+    n.locked.store(true, std::memory_order::relaxed);
+    auto *prev{tail.exchange(&n, std::memory_order::acq_rel)};
+    if (prev != nullptr) {
+      prev->next.store(&n, std::memory_order::release);
+      exponential_backoff backoff;
+      while (n.locked.load(std::memory_order::acquire))
+        backoff.pause();
+    }
+    owner = &n;
+  }
+  bool try_lock() {
+    auto &n{acquire_node()};
+    node *expected{nullptr};
+    if (!tail.compare_exchange_strong(expected, &n,
+                                      std::memory_order::acquire,
+                                      std::memory_order::relaxed)) {
+      n.in_use = false;
+      return false;
+    }
+    owner = &n;
+    return true;
+  }
+  void unlock() {
+    auto *n{owner};
+    auto *next{n->next.load(std::memory_order::acquire)};
+    if (next == nullptr) {
+      auto *expected{n};
+      if (tail.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order::release,
+                                       std::memory_order::relaxed)) {
+        n->in_use = false;
+        return;
+      }
+      exponential_backoff backoff;
+      while ((next = n->next.load(std::memory_order::acquire)) == nullptr)
+        backoff.pause();
+    }
+    next->locked.store(false, std::memory_order::release);
+    n->in_use = false;
+  }
+};
+
+// phase-fair reader-writer lock (brandenburg/anderson ticket variant).
+// reader and writer phases alternate: a reader waits for at most one
+// writer phase, a writer for the readers already inside plus the writers
+// ahead of it. neither side starves.
+// rin/rout count readers in and out in steps of reader_step, the low
+// bits of rin are the writer bits: present + the phase id of the writer.
+// reader: add to rin. writer bits set -> spin until they change.
+// writer: ticket on win/wout (fifo among writers), set its bits in rin,
+// wait until rout has caught up with the readers counted before it.
+// no try_ variants, lock/unlock and lock_shared/unlock_shared only.
+class phase_fair_rwlock {
+private:
+  static constexpr std::uint32_t reader_step{0x100};
+  static constexpr std::uint32_t writer_bits{0x3};
+  static constexpr std::uint32_t writer_present{0x2};
+  static constexpr std::uint32_t phase_id{0x1};
+
+  alignas(cache_line_size) std::atomic<std::uint32_t> rin{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> rout{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> win{0};
+  alignas(cache_line_size) std::atomic<std::uint32_t> wout{0};
+
+public:
+  void lock_shared() {
+    const auto w{rin.fetch_add(reader_step, std::memory_order::acquire) &
+                 writer_bits};
+    if (w == 0)
+      return;
+    exponential_backoff backoff;
+    while ((rin.load(std::memory_order::acquire) & writer_bits) == w)
+      backoff.pause();
+  }
+  void unlock_shared() {
+    rout.fetch_add(reader_step, std::memory_order::release);
+  }
+
+  void lock() {
+    const auto ticket{win.fetch_add(1, std::memory_order::relaxed)};
+    exponential_backoff backoff;
+    while (wout.load(std::memory_order::acquire) != ticket)
+      backoff.pause();
+    const auto readers{rin.fetch_add(writer_present | (ticket & phase_id),
+                                     std::memory_order::acq_rel)};
+    while (rout.load(std::memory_order::acquire) != readers)
+      backoff.pause();
+  }
+  // only the holder writes wout
+  void unlock() {
+    rin.fetch_and(~writer_bits, std::memory_order::release);
+    wout.store(wout.load(std::memory_order::relaxed) + 1,
+               std::memory_order::release);
+  }
+};
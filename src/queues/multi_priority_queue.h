@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "queues/locks.h"
+#include "queues/queue_layout.h"
+
+// relaxed concurrent priority queue: multiqueue of binary min-heaps, same
+// scheme as multi_queue with the head stamp replaced by the priority.
+// lane_count heaps, each behind its own spin lock, every lane publishes
+// its smallest priority in top.
+// push:
+// try_lock random lanes until one is free, push_heap there. unbounded.
+// try_pop_min:
+// sample two random lanes, try_lock the one with the smaller top and pop
+// it. contended or both empty: sample again. after lane_count misses,
+// take the non-empty lane with the smallest top, so an item that is in
+// the queue is always found.
+// try_pop_min_bulk:
+// one two-choice pick, then up to out.size() pops from that lane under a
+// single lock. cheaper per item, but the batch only comes from one lane.
+// relaxation:
+// the popped item is among the smallest with high probability, the
+// expected rank error grows linearly with lane_count. one lane is exact.
+template <typename PRIORITY, typename T> class multi_priority_queue {
+  static_assert(std::is_trivially_copyable_v<PRIORITY>,
+                "PRIORITY is published through a std::atomic");
+
+public:
+  using entry = std::pair<PRIORITY, T>;
+
+private:
+  struct alignas(cache_line_size) lane {
+    ttas_spinlock lock;
+    std::atomic<bool> empty{true};
+    std::atomic<PRIORITY> top{};
+    // lock held
+    std::vector<entry> heap;
+  };
+
+  static bool later(const entry &a, const entry &b) { return b.first < a.first; }
+
+  std::size_t _lane_count{};
+  std::unique_ptr<lane[]> _lanes;
+
+  // xorshift32, per thread
+  static std::uint32_t next_random() {
+    thread_local std::uint32_t state{static_cast<std::uint32_t>(
+        reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1};
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+  // high bits, the low bits of consecutive xorshift outputs are correlated
+  lane &random_lane() {
+    return _lanes[(std::uint64_t{next_random()} * _lane_count) >> 32];
+  }
+
+  // lock held
+  static void publish_top(lane &l) {
+    if (l.heap.empty()) {
+      l.empty.store(true, std::memory_order::relaxed);
+    } else {
+      l.top.store(l.heap.front().first, std::memory_order::relaxed);
+      l.empty.store(false, std::memory_order::relaxed);
+    }
+  }
+  static void push_locked(lane &l, PRIORITY priority, T &&value) {
+    l.heap.emplace_back(priority, std::move(value));
+    std::push_heap(l.heap.begin(), l.heap.end(), later);
+    publish_top(l);
+  }
+  static entry pop_locked(lane &l) {
+    std::pop_heap(l.heap.begin(), l.heap.end(), later);
+    entry e{std::move(l.heap.back())};
+    l.heap.pop_back();
+    return e;
+  }
+
+  // smaller top of two random lanes, nullptr if both look empty
+  lane *sample() {
+    auto *a{&random_lane()};
+    auto *b{&random_lane()};
+    if (a->empty.load(std::memory_order::relaxed))
+      std::swap(a, b);
+    if (a->empty.load(std::memory_order::relaxed))
+      return nullptr;
+    if (!b->empty.load(std::memory_order::relaxed) &&
+        b->top.load(std::memory_order::relaxed) <
+            a->top.load(std::memory_order::relaxed))
+      return b;
+    return a;
+  }
+  lane *smallest() {
+    lane *best{nullptr};
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto &l{_lanes[i]};
+      if (l.empty.load(std::memory_order::relaxed))
+        continue;
+      if (best == nullptr || l.top.load(std::memory_order::relaxed) <
+                                 best->top.load(std::memory_order::relaxed))
+        best = &l;
+    }
+    return best;
+  }
+  // locked lane with items, nullptr when all lanes are empty
+  lane *lock_min() {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto *l{sample()};
+      if (l == nullptr || !l->lock.try_lock())
+        continue;
+      if (!l->heap.empty())
+        return l;
+      l->lock.unlock();
+    }
+    while (auto *l{smallest()}) {
+      l->lock.lock();
+      if (!l->heap.empty())
+        return l;
+      l->lock.unlock();
+    }
+    return nullptr;
+  }
+
+public:
+  static std::size_t default_lane_count() {
+    return 2 * std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // size only reserves, the heaps grow
+  multi_priority_queue(size_t size = 100000,
+                       size_t lanes = default_lane_count())
+      : _lane_count{std::max<size_t>(lanes, 1)},
+        _lanes{std::make_unique<lane[]>(_lane_count)} {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      _lanes[i].heap.reserve(size / _lane_count);
+    }
+  }
+
+  std::size_t lane_count() const { return _lane_count; }
+
+  void push(PRIORITY priority, T value) {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto &l{random_lane()};
+      if (!l.lock.try_lock())
+        continue;
+      std::lock_guard<ttas_spinlock> lock(l.lock, std::adopt_lock);
+      push_locked(l, priority, std::move(value));
+      return;
+    }
+    auto &l{random_lane()};
+    std::lock_guard<ttas_spinlock> lock(l.lock);
+    push_locked(l, priority, std::move(value));
+  }
+
+  std::optional<entry> try_pop_min() {
+    auto *l{lock_min()};
+    if (l == nullptr)
+      return std::nullopt;
+    std::lock_guard<ttas_spinlock> lock(l->lock, std::adopt_lock);
+    std::optional<entry> e{pop_locked(*l)};
+    publish_top(*l);
+    return e;
+  }
+
+  // returns the number of entries moved to the front of out (0 when
+  // empty), in priority order
+  std::size_t try_pop_min_bulk(std::span<entry> out) {
+    if (out.empty())
+      return 0;
+    auto *l{lock_min()};
+    if (l == nullptr)
+      return 0;
+    std::lock_guard<ttas_spinlock> lock(l->lock, std::adopt_lock);
+    std::size_t count{0};
+    while (count < out.size() && !l->heap.empty())
+      out[count++] = pop_locked(*l);
+    publish_top(*l);
+    return count;
+  }
+};
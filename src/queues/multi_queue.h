@@ -0,0 +1,176 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "queues/locks.h"
+#include "queues/queue_layout.h"
+#include "queues/slot_storage.h"
+
+// relaxed fifo multiqueue (rihani/sanders/dementiev): lane_count small
+// fifo rings, each behind its own spin lock, no shared index at all.
+// every entry carries the time it was put, every lane publishes the
+// stamp of its oldest entry in head_stamp.
+// put:
+// try_lock random lanes until one is free and not full, push there.
+// get:
+// sample two random lanes, try_lock the one with the older head and pop
+// it. contended or both empty: sample again. after lane_count misses,
+// scan all lanes, so an item that is in the queue is always found.
+// relaxation:
+// a get returns one of the oldest entries with high probability, the
+// expected rank error (entries older than the returned one that are
+// still queued) grows linearly with lane_count. one lane is a strict
+// fifo. more lanes scale further, less order.
+// capacity is split evenly over the lanes.
+template <typename T> class multi_queue {
+private:
+  static constexpr std::uint64_t empty_stamp{
+      std::numeric_limits<std::uint64_t>::max()};
+
+  struct entry {
+    std::uint64_t stamp;
+    slot_storage<T> storage;
+  };
+  struct alignas(cache_line_size) lane {
+    ttas_spinlock lock;
+    std::atomic<std::uint64_t> head_stamp{empty_stamp};
+    // lock held
+    std::size_t read_idx{};
+    std::size_t write_idx{};
+    std::size_t size{};
+    std::unique_ptr<entry[]> data;
+  };
+
+  std::size_t _lane_count{};
+  std::size_t _lane_size{};
+  std::unique_ptr<lane[]> _lanes;
+
+  // xorshift32, per thread
+  static std::uint32_t next_random() {
+    thread_local std::uint32_t state{static_cast<std::uint32_t>(
+        reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1};
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+  // high bits, the low bits of consecutive xorshift outputs are correlated
+  lane &random_lane() {
+    return _lanes[(std::uint64_t{next_random()} * _lane_count) >> 32];
+  }
+
+  static std::uint64_t now() {
+    return static_cast<std::uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+  }
+
+  // lock held
+  template <typename U>
+  bool push_locked(lane &l, std::uint64_t stamp, U &&value) {
+    if (l.size == _lane_size)
+      return false;
+    auto &e{l.data[l.write_idx]};
+    e.stamp = stamp;
+    e.storage.emplace(std::forward<U>(value));
+    l.write_idx = (l.write_idx + 1) % _lane_size;
+    if (l.size++ == 0)
+      l.head_stamp.store(stamp, std::memory_order::relaxed);
+    return true;
+  }
+  std::optional<T> pop_locked(lane &l) {
+    if (l.size == 0)
+      return std::nullopt;
+    std::optional<T> val{l.data[l.read_idx].storage.take()};
+    l.read_idx = (l.read_idx + 1) % _lane_size;
+    l.head_stamp.store(--l.size == 0 ? empty_stamp : l.data[l.read_idx].stamp,
+                       std::memory_order::relaxed);
+    return val;
+  }
+
+  template <typename U> bool put_impl(U &&value) {
+    const auto stamp{now()};
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto &l{random_lane()};
+      if (!l.lock.try_lock())
+        continue;
+      std::lock_guard<ttas_spinlock> lock(l.lock, std::adopt_lock);
+      if (push_locked(l, stamp, std::forward<U>(value)))
+        return true;
+    }
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto &l{_lanes[i]};
+      std::lock_guard<ttas_spinlock> lock(l.lock);
+      if (push_locked(l, stamp, std::forward<U>(value)))
+        return true;
+    }
+    return false;
+  }
+
+public:
+  static std::size_t default_lane_count() {
+    return 2 * std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  multi_queue(size_t size = 100000, size_t lanes = default_lane_count())
+      : _lane_count{std::max<size_t>(lanes, 1)},
+        _lane_size{std::max<size_t>((size + _lane_count - 1) / _lane_count,
+                                    1)},
+        _lanes{std::make_unique<lane[]>(_lane_count)} {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      _lanes[i].data = std::make_unique<entry[]>(_lane_size);
+    }
+  }
+  ~multi_queue() {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      while (pop_locked(_lanes[i])) {
+      }
+    }
+  }
+
+  std::size_t lane_count() const { return _lane_count; }
+
+  bool try_put(const T &value) { return put_impl(value); }
+  // value is only moved from on success
+  bool try_put(T &&value) { return put_impl(std::move(value)); }
+
+  std::optional<T> try_get() {
+    for (std::size_t i{0}; i < _lane_count; i++) {
+      auto *a{&random_lane()};
+      auto *b{&random_lane()};
+      if (b->head_stamp.load(std::memory_order::relaxed) <
+          a->head_stamp.load(std::memory_order::relaxed))
+        a = b;
+      if (a->head_stamp.load(std::memory_order::relaxed) == empty_stamp ||
+          !a->lock.try_lock())
+        continue;
+      std::lock_guard<ttas_spinlock> lock(a->lock, std::adopt_lock);
+      if (auto val{pop_locked(*a)})
+        return val;
+    }
+    // oldest non-empty lane
+    while (true) {
+      lane *oldest{nullptr};
+      auto oldest_stamp{empty_stamp};
+      for (std::size_t i{0}; i < _lane_count; i++) {
+        const auto stamp{_lanes[i].head_stamp.load(std::memory_order::relaxed)};
+        if (stamp < oldest_stamp) {
+          oldest = &_lanes[i];
+          oldest_stamp = stamp;
+        }
+      }
+      if (oldest == nullptr)
+        return std::nullopt;
+      std::lock_guard<ttas_spinlock> lock(oldest->lock);
+      if (auto val{pop_locked(*oldest)})
+        return val;
+    }
+  }
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "queues/queue_layout.h"
+
+// disruptor style ring buffer: one producer, every entry is seen by every
+// consumer group. capacity is a power of two.
+// sequences count published/processed entries, entry s lives in slot
+// s & mask. all sequences start at -1.
+// writer:
+// next seq = cursor + 1, wait until seq - capacity <= slowest group
+// (cached, only refreshed when the ring looks full), fill the entry,
+// publish by storing cursor = seq.
+// consumer group:
+// barrier = min(cursor or the sequences of the groups it depends on),
+// process every entry up to the barrier in one batch, store sequence.
+// groups must be added before the producer starts.
+template <typename T> class multicast_ring {
+public:
+  class consumer_group {
+    friend class multicast_ring;
+
+    // groups are allocated one by one, so this is one line per group
+    alignas(cache_line_size) std::atomic<std::int64_t> _sequence{-1};
+    multicast_ring *_ring;
+    std::vector<const std::atomic<std::int64_t> *> _barrier;
+
+    consumer_group(multicast_ring *ring,
+                   std::vector<const std::atomic<std::int64_t> *> barrier)
+        : _ring{ring}, _barrier{std::move(barrier)} {}
+
+    std::int64_t available() const {
+      auto seq{std::numeric_limits<std::int64_t>::max()};
+      for (const auto *dependency : _barrier) {
+        seq = std::min(seq, dependency->load(std::memory_order::acquire));
+      }
+      return seq;
+    }
+
+  public:
+    std::int64_t sequence() const {
+      return _sequence.load(std::memory_order::acquire);
+    }
+
+    // calls handler(T&, sequence) for every available entry, in order.
+    // returns the number of entries processed (0 when nothing is ready)
+    template <typename HANDLER> std::size_t try_consume(HANDLER &&handler) {
+      const auto next{_sequence.load(std::memory_order::relaxed) + 1};
+      const auto last{available()};
+      if (last < next)
+        return 0;
+      for (auto seq{next}; seq <= last; seq++) {
+        handler(_ring->at(seq), seq);
+      }
+      _sequence.store(last, std::memory_order::release);
+      return static_cast<std::size_t>(last - next + 1);
+    }
+    template <typename HANDLER> std::size_t consume(HANDLER &&handler) {
+      while (true) {
+        if (const auto count{try_consume(handler)})
+          return count;
+        std::this_thread::yield();
+      }
+    }
+  };
+
+private:
+  std::size_t _mask{};
+  std::unique_ptr<T[]> _data;
+  std::vector<std::unique_ptr<consumer_group>> _groups;
+
+  alignas(cache_line_size) std::atomic<std::int64_t> cursor{-1};
+
+  // producer line
+  alignas(cache_line_size) std::int64_t next_seq{0};
+  std::int64_t cached_slowest{-1};
+
+  T &at(std::int64_t seq) { return _data[seq & _mask]; }
+
+  std::int64_t slowest() const {
+    auto seq{cursor.load(std::memory_order::relaxed)};
+    for (const auto &group : _groups) {
+      seq = std::min(seq, group->sequence());
+    }
+    return seq;
+  }
+
+public:
+  multicast_ring(size_t size = 1024)
+      : _mask{std::bit_ceil(std::max<size_t>(size, 1)) - 1},
+        _data{std::make_unique<T[]>(_mask + 1)} {}
+
+  std::size_t capacity() const { return _mask + 1; }
+
+  // new group that sees an entry only after all of depends_on processed it,
+  // without dependencies it follows the producer directly
+  consumer_group &
+  add_consumer_group(std::initializer_list<const consumer_group *> depends_on =
+                         {}) {
+    std::vector<const std::atomic<std::int64_t> *> barrier;
+    for (const auto *group : depends_on) {
+      barrier.push_back(&group->_sequence);
+    }
+    if (barrier.empty())
+      barrier.push_back(&cursor);
+    _groups.push_back(std::unique_ptr<consumer_group>(
+        new consumer_group(this, std::move(barrier))));
+    return *_groups.back();
+  }
+
+  // fill(T&) writes the entry in place, waits while the ring is full
+  template <typename FILL> void publish(FILL &&fill) {
+    const auto seq{next_seq++};
+    const auto wrap_point{seq - static_cast<std::int64_t>(capacity())};
+    while (wrap_point > cached_slowest) {
+      cached_slowest = slowest();
+      if (wrap_point > cached_slowest)
+        std::this_thread::yield();
+    }
+    fill(at(seq));
+    cursor.store(seq, std::memory_order::release);
+  }
+  void put(const T &value) {
+    publish([&](T &entry) { entry = value; });
+  }
+};
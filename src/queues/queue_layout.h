@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+
+// fixed value, std::hardware_destructive_interference_size changes with
+// -mtune/-mcpu and gcc warns about it in headers.
+// apple silicon prefetches/shares in 128 byte units.
+#if defined(__APPLE__) && defined(__aarch64__)
+inline constexpr std::size_t cache_line_size{128};
+#else
+inline constexpr std::size_t cache_line_size{64};
+#endif
+
+// memory layout policy for ring buffer queues.
+// PAD_INDICES: read/write index each on their own cache line.
+// PAD_SLOTS: every slot on its own cache line.
+// REMAP: ticket i and i + 1 land on different cache lines, the ring is
+// viewed as lines x slots_per_line and walked column by column.
+template <bool PAD_INDICES, bool PAD_SLOTS, bool REMAP> struct queue_layout {
+  static constexpr bool pad_indices{PAD_INDICES};
+  static constexpr bool pad_slots{PAD_SLOTS};
+  static constexpr bool remap{REMAP};
+
+  // minimum alignment, combine with the member's natural alignment
+  static constexpr std::size_t index_align{PAD_INDICES ? cache_line_size : 1};
+  static constexpr std::size_t slot_align{PAD_SLOTS ? cache_line_size : 1};
+};
+
+using compact_layout = queue_layout<false, false, false>;
+using padded_layout = queue_layout<true, false, false>;
+using padded_slots_layout = queue_layout<true, true, false>;
+using remapped_layout = queue_layout<true, false, true>;
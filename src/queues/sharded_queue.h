@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "queues/lockfree_queue_fixed.h"
+
+// N independent lockfree_queue_fixed rings.
+// every thread gets a home shard on first use (round robin over threads).
+// writer:
+// try home shard, if full try the remaining shards in order.
+// reader:
+// try home shard first, then steal from the remaining shards in order.
+// ordering is relaxed: items are FIFO per shard, but not across shards.
+template <typename T> class sharded_queue {
+private:
+  std::vector<std::unique_ptr<lockfree_queue_fixed<T>>> _shards;
+
+  static std::size_t thread_idx() {
+    static std::atomic<std::size_t> next_thread_idx{0};
+    thread_local const std::size_t idx{
+        next_thread_idx.fetch_add(1, std::memory_order::relaxed)};
+    return idx;
+  }
+  std::size_t home_shard() const { return thread_idx() % _shards.size(); }
+
+public:
+  sharded_queue(size_t size = 100000,
+                size_t shards = std::thread::hardware_concurrency()) {
+    shards = std::max<size_t>(shards, 1);
+    const auto shard_size{(size + shards - 1) / shards};
+    _shards.reserve(shards);
+    for (size_t i{0}; i < shards; i++) {
+      _shards.push_back(std::make_unique<lockfree_queue_fixed<T>>(shard_size));
+    }
+  }
+
+  std::size_t shard_count() const { return _shards.size(); }
+
+  bool try_put(const T &value) {
+    const auto home{home_shard()};
+    for (size_t i{0}; i < _shards.size(); i++) {
+      if (_shards[(home + i) % _shards.size()]->try_put(value))
+        return true;
+    }
+    return false;
+  }
+  std::optional<T> try_get() {
+    const auto home{home_shard()};
+    for (size_t i{0}; i < _shards.size(); i++) {
+      if (auto val{_shards[(home + i) % _shards.size()]->try_get()})
+        return val;
+    }
+    return std::nullopt;
+  }
+};
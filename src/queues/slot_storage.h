@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// uninitialized storage for one T, the owning queue tracks whether a value
+// lives in it. lets queues hold move-only and non-default-constructible T
+// without constructing the whole buffer up front.
+template <typename T> struct slot_storage {
+  alignas(T) std::byte bytes[sizeof(T)];
+
+  T *get() { return std::launder(reinterpret_cast<T *>(bytes)); }
+
+  template <typename... ARGS> void emplace(ARGS &&...args) {
+    std::construct_at(reinterpret_cast<T *>(bytes),
+                      std::forward<ARGS>(args)...);
+  }
+  // default-initialization, trivial T stays uninitialized
+  void default_construct() { ::new (static_cast<void *>(bytes)) T; }
+  // moves the value out and ends its lifetime
+  T take() {
+    T val{std::move(*get())};
+    std::destroy_at(get());
+    return val;
+  }
+  void destroy() { std::destroy_at(get()); }
+};
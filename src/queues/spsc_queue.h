@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "queues/queue_layout.h"
+
+// single producer, single consumer ring buffer, capacity is a power of two.
+// no CAS: each index has exactly one writer.
+// writer:
+// write_idx - cached_read_idx >= capacity: refresh cached_read_idx, full?
+// write slot, publish write_idx.
+// reader:
+// read_idx == cached_write_idx: refresh cached_write_idx, empty?
+// read slot, publish read_idx.
+// the cached copies live on the owner's cache line, so the other side's
+// index is only loaded when the ring looks full/empty.
+// zero copy: try_reserve hands out the next slot to fill in place, commit
+// publishes it. try_peek hands out the oldest value, release frees it.
+template <typename T> class spsc_queue {
+private:
+  std::size_t _mask{};
+  std::unique_ptr<T[]> _data;
+
+  // producer line
+  alignas(cache_line_size) std::atomic<std::size_t> write_idx{0};
+  std::size_t cached_read_idx{0};
+
+  // consumer line
+  alignas(cache_line_size) std::atomic<std::size_t> read_idx{0};
+  std::size_t cached_write_idx{0};
+
+public:
+  spsc_queue(size_t size = 100000)
+      : _mask{std::bit_ceil(std::max<size_t>(size, 1)) - 1},
+        _data{std::make_unique<T[]>(_mask + 1)} {}
+
+  std::size_t capacity() const { return _mask + 1; }
+
+  bool try_put(const T &value) {
+    auto slot{try_reserve()};
+    if (slot == nullptr)
+      return false;
+    *slot = value;
+    commit();
+    return true;
+  }
+  std::optional<T> try_get() {
+    auto slot{try_peek()};
+    if (slot == nullptr)
+      return std::nullopt;
+    std::optional<T> val{std::move(*slot)};
+    release();
+    return val;
+  }
+
+  T *try_reserve() {
+    const auto local_write_idx{write_idx.load(std::memory_order::relaxed)};
+    if (local_write_idx - cached_read_idx > _mask) {
+      cached_read_idx = read_idx.load(std::memory_order::acquire);
+      if (local_write_idx - cached_read_idx > _mask)
+        return nullptr;
+    }
+    return &_data[local_write_idx & _mask];
+  }
+  void commit() {
+    write_idx.store(write_idx.load(std::memory_order::relaxed) + 1,
+                    std::memory_order::release);
+  }
+  T *try_peek() {
+    const auto local_read_idx{read_idx.load(std::memory_order::relaxed)};
+    if (local_read_idx == cached_write_idx) {
+      cached_write_idx = write_idx.load(std::memory_order::acquire);
+      if (local_read_idx == cached_write_idx)
+        return nullptr;
+    }
+    return &_data[local_read_idx & _mask];
+  }
+  void release() {
+    read_idx.store(read_idx.load(std::memory_order::relaxed) + 1,
+                   std::memory_order::release);
+  }
+};
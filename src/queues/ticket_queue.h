@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include "queues/queue_layout.h"
+
+// bounded MPMC queue, tickets instead of CAS retry loops.
+// every slot has a turn counter, ticket t maps to slot t % size in lap
+// t / size. the slot is free for lap l when turn == 2 * l and holds the
+// value of lap l when turn == 2 * l + 1.
+// writer:
+// fetch_add write_idx, wait until the slot's turn is 2 * lap,
+// write data, set turn to 2 * lap + 1.
+// reader:
+// fetch_add read_idx, wait until the slot's turn is 2 * lap + 1,
+// read data, set turn to 2 * lap + 2.
+// the try_ variants only take a ticket (CAS) if the slot is ready for it,
+// so they never wait.
+template <typename T> class ticket_queue {
+  struct alignas(cache_line_size) slot {
+    std::atomic<std::size_t> turn{0};
+    T data{};
+  };
+
+private:
+  std::size_t _size{};
+  std::unique_ptr<slot[]> _data;
+
+  alignas(cache_line_size) std::atomic<std::size_t> write_idx{0};
+  alignas(cache_line_size) std::atomic<std::size_t> read_idx{0};
+
+  std::size_t lap(std::size_t ticket) const { return ticket / _size; }
+  slot &slot_at(std::size_t ticket) { return _data[ticket % _size]; }
+
+  static void wait_for_turn(const slot &slot, std::size_t turn) {
+    while (slot.turn.load(std::memory_order::acquire) != turn) {
+      std::this_thread::yield();
+    }
+  }
+
+public:
+  ticket_queue(size_t size = 100000)
+      : _size{size}, _data{std::make_unique<slot[]>(size)} {}
+
+  void put(const T &value) {
+    const auto ticket{write_idx.fetch_add(1, std::memory_order::relaxed)};
+    auto &slot{slot_at(ticket)};
+    wait_for_turn(slot, 2 * lap(ticket));
+    slot.data = value;
+    slot.turn.store(2 * lap(ticket) + 1, std::memory_order::release);
+  }
+  T get() {
+    const auto ticket{read_idx.fetch_add(1, std::memory_order::relaxed)};
+    auto &slot{slot_at(ticket)};
+    wait_for_turn(slot, 2 * lap(ticket) + 1);
+    T val{std::move(slot.data)};
+    slot.turn.store(2 * lap(ticket) + 2, std::memory_order::release);
+    return val;
+  }
+
+  bool try_put(const T &value) {
+    auto ticket{write_idx.load(std::memory_order::acquire)};
+    while (true) {
+      auto &slot{slot_at(ticket)};
+      if (slot.turn.load(std::memory_order::acquire) == 2 * lap(ticket)) {
+        if (write_idx.compare_exchange_strong(ticket, ticket + 1,
+                                              std::memory_order::relaxed)) {
+          slot.data = value;
+          slot.turn.store(2 * lap(ticket) + 1, std::memory_order::release);
+          return true;
+        }
+      } else {
+        // slot still holds the previous lap: full, unless someone moved on
+        const auto prev_ticket{ticket};
+        ticket = write_idx.load(std::memory_order::acquire);
+        if (ticket == prev_ticket)
+          return false;
+      }
+    }
+  }
+  std::optional<T> try_get() {
+    auto ticket{read_idx.load(std::memory_order::acquire)};
+    while (true) {
+      auto &slot{slot_at(ticket)};
+      if (slot.turn.load(std::memory_order::acquire) == 2 * lap(ticket) + 1) {
+        if (read_idx.compare_exchange_strong(ticket, ticket + 1,
+                                             std::memory_order::relaxed)) {
+          std::optional<T> val{std::move(slot.data)};
+          slot.turn.store(2 * lap(ticket) + 2, std::memory_order::release);
+          return val;
+        }
+      } else {
+        const auto prev_ticket{ticket};
+        ticket = read_idx.load(std::memory_order::acquire);
+        if (ticket == prev_ticket)
+          return std::nullopt;
+      }
+    }
+  }
+  template <typename REP, typename PERIOD>
+  std::optional<T> try_get_for(std::chrono::duration<REP, PERIOD> timeout) {
+    const auto deadline{std::chrono::steady_clock::now() + timeout};
+    while (true) {
+      if (auto val{try_get()})
+        return val;
+      if (std::chrono::steady_clock::now() >= deadline)
+        return std::nullopt;
+      std::this_thread::yield();
+    }
+  }
+};
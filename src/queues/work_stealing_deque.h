@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "queues/queue_layout.h"
+
+// chase-lev work-stealing deque (le et al., "correct and efficient
+// work-stealing for weak memory models").
+// the owner pushes and pops at the bottom, thieves steal at the top.
+// entries live in a circular array indexed by top <= i < bottom.
+// owner push:
+// grow the array if it is full, write entry, publish bottom + 1.
+// owner pop:
+// bottom - 1 first, then look at top. more than one entry: take it.
+// last entry: race the thieves for it with a CAS on top.
+// thief steal:
+// read top, then bottom. non-empty: read the entry, claim it with a CAS
+// on top. losing the CAS means somebody else took it.
+// growing:
+// only the owner grows, it copies [top, bottom) into an array twice the
+// size. thieves may still read the old array, so old arrays are kept
+// until the deque is destroyed (at most as much memory as the live one).
+// T must be trivially copyable (usually a pointer to the work item).
+template <typename T> class work_stealing_deque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "entries are copied with plain atomic loads/stores");
+
+  struct array {
+    std::size_t mask;
+    std::unique_ptr<std::atomic<T>[]> data;
+
+    explicit array(std::size_t capacity)
+        : mask{capacity - 1},
+          data{std::make_unique<std::atomic<T>[]>(capacity)} {}
+
+    std::size_t capacity() const { return mask + 1; }
+    T get(std::int64_t i) const {
+      return data[i & mask].load(std::memory_order::relaxed);
+    }
+    void put(std::int64_t i, T value) {
+      data[i & mask].store(value, std::memory_order::relaxed);
+    }
+  };
+
+private:
+  alignas(cache_line_size) std::atomic<std::int64_t> top{0};
+  alignas(cache_line_size) std::atomic<std::int64_t> bottom{0};
+  alignas(cache_line_size) std::atomic<array *> _array;
+  // owner only
+  std::vector<std::unique_ptr<array>> _arrays;
+
+  array *grow(array *old, std::int64_t t, std::int64_t b) {
+    _arrays.push_back(std::make_unique<array>(old->capacity() * 2));
+    auto *bigger{_arrays.back().get()};
+    for (auto i{t}; i < b; i++) {
+      bigger->put(i, old->get(i));
+    }
+    _array.store(bigger, std::memory_order::release);
+    return bigger;
+  }
+
+public:
+  work_stealing_deque(size_t size = 1024) {
+    _arrays.push_back(
+        std::make_unique<array>(std::bit_ceil(std::max<size_t>(size, 2))));
+    _array.store(_arrays.back().get(), std::memory_order::relaxed);
+  }
+
+  // approximate, exact only when called by the owner with no thieves
+  std::size_t size() const {
+    const auto b{bottom.load(std::memory_order::relaxed)};
+    const auto t{top.load(std::memory_order::relaxed)};
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+  std::size_t capacity() const {
+    return _array.load(std::memory_order::relaxed)->capacity();
+  }
+
+  // owner only
+  void push(T value) {
+    const auto b{bottom.load(std::memory_order::relaxed)};
+    const auto t{top.load(std::memory_order::acquire)};
+    auto *a{_array.load(std::memory_order::relaxed)};
+    if (b - t > static_cast<std::int64_t>(a->mask))
+      a = grow(a, t, b);
+    a->put(b, value);
+    bottom.store(b + 1, std::memory_order::release);
+  }
+
+  // owner only, newest entry first
+  std::optional<T> pop() {
+    const auto b{bottom.load(std::memory_order::relaxed) - 1};
+    auto *a{_array.load(std::memory_order::relaxed)};
+    // seq_cst store/load pair instead of the paper's fence: the thieves
+    // must see the smaller bottom before we look at top
+    bottom.store(b, std::memory_order::seq_cst);
+    auto t{top.load(std::memory_order::seq_cst)};
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order::relaxed);
+      return std::nullopt;
+    }
+    std::optional<T> value{a->get(b)};
+    if (t == b) {
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order::seq_cst,
+                                       std::memory_order::relaxed))
+        value.reset();
+      bottom.store(b + 1, std::memory_order::relaxed);
+    }
+    return value;
+  }
+
+  // any thread, oldest entry first. nullopt when empty or when another
+  // thread won the race for the top entry
+  std::optional<T> steal() {
+    auto t{top.load(std::memory_order::seq_cst)};
+    const auto b{bottom.load(std::memory_order::seq_cst)};
+    if (t >= b)
+      return std::nullopt;
+    const T value{_array.load(std::memory_order::acquire)->get(t)};
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order::seq_cst,
+                                     std::memory_order::relaxed))
+      return std::nullopt;
+    return value;
+  }
+};
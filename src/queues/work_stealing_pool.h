@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "queues/event_count.h"
+#include "queues/lockfree_queue_unbounded.h"
+#include "queues/queue_layout.h"
+#include "queues/work_stealing_deque.h"
+
+// fork/join thread pool on top of work_stealing_deque.
+// every worker owns a deque. tasks submitted by a worker go to the bottom
+// of its own deque and are popped from there again (newest first, the
+// data is still in cache). a worker without work steals the oldest task
+// of the other workers, starting at a different victim every time.
+// tasks submitted by other threads go through a shared injection queue.
+// wait_until(pred) runs tasks until pred() holds, so a task that waits
+// for its children keeps its worker busy instead of blocking it.
+// idle workers spin a few rounds, then park on an event_count.
+class work_stealing_pool {
+public:
+  using task = std::function<void()>;
+
+private:
+  struct worker {
+    work_stealing_deque<task *> deque;
+    std::size_t next_victim{};
+  };
+
+  static constexpr int spin_tries{64};
+
+  std::vector<std::unique_ptr<worker>> _workers;
+  std::vector<std::thread> _threads;
+  lockfree_queue_unbounded<task *> _injected;
+  alignas(cache_line_size) std::atomic<std::size_t> _injected_count{0};
+  alignas(cache_line_size) std::atomic<bool> _stop{false};
+  event_count _work_available;
+
+  inline static thread_local work_stealing_pool *current_pool{};
+  inline static thread_local worker *current_worker{};
+
+  worker *local_worker() const {
+    return current_pool == this ? current_worker : nullptr;
+  }
+
+  task *find_task() {
+    auto *self{local_worker()};
+    if (self != nullptr) {
+      if (auto t{self->deque.pop()})
+        return *t;
+    }
+    if (_injected_count.load(std::memory_order::relaxed) > 0) {
+      if (auto t{_injected.try_get()}) {
+        _injected_count.fetch_sub(1, std::memory_order::relaxed);
+        return *t;
+      }
+    }
+    const auto n{_workers.size()};
+    const auto start{self != nullptr ? self->next_victim++ : 0};
+    for (std::size_t i{0}; i < n; i++) {
+      auto &victim{*_workers[(start + i) % n]};
+      if (&victim == self)
+        continue;
+      if (auto t{victim.deque.steal()})
+        return *t;
+    }
+    return nullptr;
+  }
+
+  bool has_work() const {
+    // pairs with the fence in submit
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (_injected_count.load(std::memory_order::seq_cst) > 0)
+      return true;
+    for (const auto &w : _workers) {
+      if (w->deque.size() > 0)
+        return true;
+    }
+    return false;
+  }
+
+  static void run(task *t) {
+    (*t)();
+    delete t;
+  }
+
+  void worker_loop(worker *self) {
+    current_pool = this;
+    current_worker = self;
+    while (!_stop.load(std::memory_order::relaxed)) {
+      task *t{};
+      for (int i{0}; i < spin_tries && t == nullptr; i++) {
+        t = find_task();
+        if (t == nullptr)
+          std::this_thread::yield();
+      }
+      if (t != nullptr) {
+        run(t);
+        continue;
+      }
+      _work_available.wait([&] { return _stop.load() || has_work(); });
+    }
+  }
+
+public:
+  work_stealing_pool(size_t threads = std::thread::hardware_concurrency()) {
+    const auto n{std::max<size_t>(threads, 1)};
+    for (std::size_t i{0}; i < n; i++) {
+      _workers.push_back(std::make_unique<worker>());
+      _workers.back()->next_victim = i + 1;
+    }
+    for (auto &w : _workers) {
+      _threads.emplace_back([this, w = w.get()] { worker_loop(w); });
+    }
+  }
+  ~work_stealing_pool() {
+    _stop.store(true);
+    _work_available.notify_all();
+    for (auto &t : _threads) {
+      t.join();
+    }
+    // tasks nobody ran
+    for (auto &w : _workers) {
+      while (auto t{w->deque.pop()}) {
+        delete *t;
+      }
+    }
+    while (auto t{_injected.try_get()}) {
+      delete *t;
+    }
+  }
+
+  std::size_t thread_count() const { return _workers.size(); }
+
+  void submit(task f) {
+    auto *t{new task(std::move(f))};
+    if (auto *self{local_worker()}) {
+      self->deque.push(t);
+      // pairs with the waiter's seq_cst increment in event_count
+      std::atomic_thread_fence(std::memory_order::seq_cst);
+    } else {
+      _injected_count.fetch_add(1, std::memory_order::seq_cst);
+      _injected.try_put(t);
+    }
+    _work_available.notify_all();
+  }
+
+  // runs queued tasks (of any thread) until ready() is true
+  template <typename PRED> void wait_until(PRED ready) {
+    while (!ready()) {
+      if (auto *t{find_task()}) {
+        run(t);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
@@ -1,12 +1,31 @@
 #include <gtest/gtest.h>
+#include <array>
 #include <memory>
 #include <thread>
-#include <barrier> 
+#include <barrier>
+#include <numeric>
+#include <span>
 #include <unordered_set>
+#include "queues/flat_combining_queue.h"
+#include "queues/intrusive_mpsc_queue.h"
+#include "queues/locking_queue.h"
 #include "queues/locking_queue_circular_buffer.h"
 #include "queues/locking_queue_shared_mutex.h"
+#include "queues/locking_queue_two_lock.h"
+#include "queues/epoch_reclamation.h"
 #include "queues/lockfree_queue.h"
+#include "queues/lockfree_queue_dynamic.h"
 #include "queues/lockfree_queue_fixed.h"
+#include "queues/lockfree_queue_ms.h"
+#include "queues/lockfree_queue_unbounded.h"
+#include "queues/multi_priority_queue.h"
+#include "queues/multi_queue.h"
+#include "queues/multicast_ring.h"
+#include "queues/sharded_queue.h"
+#include "queues/spsc_queue.h"
+#include "queues/ticket_queue.h"
+#include "queues/work_stealing_deque.h"
+#include "queues/work_stealing_pool.h"
 template <typename T>
 class QueueTest : public ::testing::Test {
  protected:
@@ -16,7 +35,23 @@ class QueueTest : public ::testing::Test {
 
 using QueueTypes =
     ::testing::Types<lockfree_queue<int>, locking_queue_with_shared_mutex<int>,
-                     locking_queue_with_circular_buffer<int>, lockfree_queue_fixed<int>>;
+                     locking_queue_with_circular_buffer<int>, lockfree_queue_fixed<int>,
+                     sharded_queue<int>, lockfree_queue_unbounded<int>,
+                     lockfree_queue_unbounded<int, 8>,
+                     lockfree_queue_fixed<int, padded_slots_layout>,
+                     lockfree_queue_fixed<int, remapped_layout>,
+                     ticket_queue<int>, lockfree_queue_dynamic<int>,
+                     locking_queue_two_lock<int>, lockfree_queue_ms<int>,
+                     flat_combining_queue<int>, locking_queue<int, mcs_lock>,
+                     locking_queue_with_circular_buffer<int, ttas_spinlock>,
+                     locking_queue_with_circular_buffer<int, ticket_lock>,
+                     locking_queue_two_lock<int, mcs_lock>,
+                     locking_queue_with_shared_mutex<int, std::shared_mutex>,
+                     lockfree_queue_fixed<int, compact_layout, exponential_backoff>,
+                     lockfree_queue<int, spin_yield_sleep_backoff>,
+                     locking_queue_with_shared_mutex<int, phase_fair_rwlock,
+                                                     exponential_backoff>,
+                     multi_queue<int>>;
 
 TYPED_TEST_SUITE(QueueTest, QueueTypes);
 
@@ -100,12 +135,15 @@ TYPED_TEST(QueueTest, two_producers_two_consumers) {
   // Readers
   auto reader = [&]() {
     while (true) {
+      // read before try_get: a put that lands behind the scan must not be
+      // mistaken for the end
+      const bool done = writers_done;
       auto opt = q.try_get();
       if (opt) {
         std::lock_guard<std::mutex> lock(removed_mutex);
         removed.insert(*opt);
       } else {
-        if (writers_done) {
+        if (done) {
           // No more writers, no more data
           break;
         }
@@ -214,3 +252,755 @@ TYPED_TEST(QueueTest, stress_randomized_with_timeout_and_spinlimit) {
     ASSERT_TRUE(consumed_values.count(i) == 1);
   }
 }
+TEST(LockfreeQueueFixedTest, bulk_put_get) {
+  const int producers = 2;
+  const int N = 64 * 80;  // items per producer, multiple of the batch size
+  lockfree_queue_fixed<int> q(256);
+
+  auto producer = [&](int id) {
+    std::vector<int> batch(64);
+    for (int i = 0; i < N; i += batch.size()) {
+      std::iota(batch.begin(), batch.end(), id * N + i);
+      std::span<const int> pending{batch};
+      while (!pending.empty()) {
+        pending = pending.subspan(q.try_put_bulk(pending));
+        std::this_thread::yield();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < producers; i++) threads.emplace_back(producer, i);
+
+  std::unordered_set<int> consumed;
+  std::vector<int> out(100);
+  while (consumed.size() < std::size_t{producers} * N) {
+    const auto got{q.try_get_bulk(std::span<int>{out})};
+    ASSERT_LE(got, out.size());
+    for (std::size_t i{0}; i < got; i++) {
+      ASSERT_TRUE(consumed.insert(out[i]).second) << "Duplicate " << out[i];
+    }
+    if (got == 0) std::this_thread::yield();
+  }
+  for (auto& t : threads) t.join();
+  EXPECT_EQ(q.try_get_bulk(std::span<int>{out}), 0);
+  EXPECT_FALSE(q.try_get().has_value());
+}
+TEST(ShardedQueueTest, steal_from_other_shards) {
+  const int N = 1000;
+  sharded_queue<int> q(4 * N, 4);
+  ASSERT_EQ(q.shard_count(), 4);
+
+  // each producer thread lands on its own home shard
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 4; p++) {
+    producers.emplace_back([&, p]() {
+      for (int i = 0; i < N; i++) {
+        ASSERT_TRUE(q.try_put(p * N + i));
+      }
+    });
+  }
+  for (auto& t : producers) t.join();
+
+  // a single consumer drains every shard
+  std::unordered_set<int> consumed;
+  while (auto val{q.try_get()}) {
+    ASSERT_TRUE(consumed.insert(*val).second) << "Duplicate " << *val;
+  }
+  EXPECT_EQ(consumed.size(), 4 * N);
+}
+TEST(SpscQueueTest, one_producer_one_consumer_in_order) {
+  const int N = 100000;
+  spsc_queue<int> q(1000);
+  ASSERT_EQ(q.capacity(), 1024);
+
+  std::thread producer([&]() {
+    for (int i = 0; i < N; i++) {
+      while (!q.try_put(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  for (int expected = 0; expected < N;) {
+    auto val{q.try_get()};
+    if (val) {
+      ASSERT_EQ(*val, expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_FALSE(q.try_get().has_value());
+}
+template <typename T>
+class BlockingQueueTest : public QueueTest<T> {};
+
+using BlockingQueueTypes =
+    ::testing::Types<lockfree_queue_fixed<int>,
+                     locking_queue_with_circular_buffer<int>, ticket_queue<int>,
+                     locking_queue_with_circular_buffer<int, mcs_lock>>;
+
+TYPED_TEST_SUITE(BlockingQueueTest, BlockingQueueTypes);
+
+TYPED_TEST(BlockingQueueTest, blocking_put_get) {
+  const int producers = 2;
+  const int consumers = 2;
+  const int N = 5000;  // items per producer, more than the capacity
+  auto& q = *this->queue;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < N; i++) q.put(p * N + i);
+    });
+  }
+  std::mutex consumed_mutex;
+  std::unordered_set<int> consumed;
+  for (int c = 0; c < consumers; c++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < producers * N / consumers; i++) {
+        const auto val{q.get()};
+        std::lock_guard<std::mutex> lock(consumed_mutex);
+        ASSERT_TRUE(consumed.insert(val).second) << "Duplicate " << val;
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+  EXPECT_EQ(consumed.size(), producers * N);
+}
+TYPED_TEST(BlockingQueueTest, try_get_for) {
+  using namespace std::chrono_literals;
+  auto& q = *this->queue;
+
+  const auto start{std::chrono::steady_clock::now()};
+  EXPECT_FALSE(q.try_get_for(20ms).has_value());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(10ms);
+    q.put(42);
+  });
+  const auto val{q.try_get_for(10s)};
+  producer.join();
+  ASSERT_TRUE(val.has_value());
+  EXPECT_EQ(*val, 42);
+}
+template <typename T>
+class MoveOnlyQueueTest : public QueueTest<T> {};
+
+using MoveOnlyQueueTypes =
+    ::testing::Types<lockfree_queue_fixed<std::unique_ptr<int>>,
+                     locking_queue_with_circular_buffer<std::unique_ptr<int>>,
+                     locking_queue_with_shared_mutex<std::unique_ptr<int>>>;
+
+TYPED_TEST_SUITE(MoveOnlyQueueTest, MoveOnlyQueueTypes);
+
+TYPED_TEST(MoveOnlyQueueTest, put_emplace_get) {
+  auto& q = *this->queue;
+  auto value{std::make_unique<int>(1)};
+  ASSERT_TRUE(q.try_put(std::move(value)));
+  EXPECT_EQ(value, nullptr);
+  ASSERT_TRUE(q.try_emplace(new int{2}));
+
+  auto first{q.try_get()};
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(**first, 1);
+  auto second{q.try_get()};
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(**second, 2);
+  EXPECT_FALSE(q.try_get().has_value());
+
+  // values left in the queue are destroyed with it
+  ASSERT_TRUE(q.try_emplace(new int{3}));
+}
+TYPED_TEST(MoveOnlyQueueTest, failed_put_keeps_value) {
+  auto& q = *this->queue;
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_TRUE(q.try_emplace(new int{i}));
+  }
+  auto value{std::make_unique<int>(-1)};
+  EXPECT_FALSE(q.try_put(std::move(value)));
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(*value, -1);
+}
+
+// neither default constructible nor copyable
+struct no_default {
+  explicit no_default(int id) : id{id} {}
+  no_default(no_default&&) = default;
+  no_default& operator=(no_default&&) = default;
+  int id;
+};
+TEST(LockfreeQueueFixedTest, non_default_constructible) {
+  lockfree_queue_fixed<no_default> q(4);
+  for (int i = 0; i < 4; i++) ASSERT_TRUE(q.try_emplace(i));
+  EXPECT_FALSE(q.try_emplace(4));
+  for (int i = 0; i < 4; i++) EXPECT_EQ(q.try_get()->id, i);
+  EXPECT_FALSE(q.try_get().has_value());
+}
+TEST(LockfreeQueueFixedTest, reserve_commit_peek_release) {
+  lockfree_queue_fixed<std::array<int, 16>> q(2);
+  auto first{q.try_reserve()};
+  ASSERT_TRUE(first.has_value());
+  auto second{q.try_reserve()};
+  ASSERT_TRUE(second.has_value());
+  EXPECT_FALSE(q.try_reserve().has_value());
+
+  second->value().fill(2);
+  q.commit(*second);
+  // the first reservation is not committed yet
+  EXPECT_FALSE(q.try_peek().has_value());
+  first->value().fill(1);
+  q.commit(*first);
+
+  for (int expected = 1; expected <= 2; expected++) {
+    auto read{q.try_peek()};
+    ASSERT_TRUE(read.has_value());
+    EXPECT_EQ(read->value().front(), expected);
+    EXPECT_EQ(read->value().back(), expected);
+    q.release(*read);
+  }
+  EXPECT_FALSE(q.try_peek().has_value());
+  EXPECT_TRUE(q.try_reserve().has_value());
+}
+TEST(SpscQueueTest, reserve_commit_peek_release) {
+  spsc_queue<std::array<int, 16>> q(2);
+  for (int i = 0; i < 2; i++) {
+    auto slot{q.try_reserve()};
+    ASSERT_NE(slot, nullptr);
+    slot->fill(i);
+    q.commit();
+  }
+  EXPECT_EQ(q.try_reserve(), nullptr);
+  for (int i = 0; i < 2; i++) {
+    auto slot{q.try_peek()};
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->back(), i);
+    q.release();
+  }
+  EXPECT_EQ(q.try_peek(), nullptr);
+}
+TEST(LockfreeQueueUnboundedTest, move_only_and_non_default_constructible) {
+  lockfree_queue_unbounded<std::unique_ptr<int>, 8> q(8);
+  auto value{std::make_unique<int>(-1)};
+  ASSERT_TRUE(q.try_put(std::move(value)));
+  EXPECT_EQ(value, nullptr);
+  // crosses segments
+  for (int i = 0; i < 20; i++) ASSERT_TRUE(q.try_emplace(new int{i}));
+  EXPECT_EQ(**q.try_get(), -1);
+  for (int i = 0; i < 10; i++) EXPECT_EQ(**q.try_get(), i);
+  // values left in the queue are destroyed with it
+
+  lockfree_queue_unbounded<no_default, 8> nd(8);
+  for (int i = 0; i < 20; i++) ASSERT_TRUE(nd.try_emplace(i));
+  for (int i = 0; i < 20; i++) EXPECT_EQ(nd.try_get()->id, i);
+  EXPECT_FALSE(nd.try_get().has_value());
+}
+
+TEST(LockfreeQueueDynamicTest, grows_under_backlog_and_shrinks_when_idle) {
+  lockfree_queue_dynamic<int> q(4096, 16);
+  const auto idle_bytes{q.allocated_bytes()};
+
+  const int N = 20000;
+  for (int i = 0; i < N; i++) ASSERT_TRUE(q.try_put(i));
+  const auto peak_bytes{q.allocated_bytes()};
+  EXPECT_GT(peak_bytes, 16 * idle_bytes);
+
+  for (int i = 0; i < N; i++) {
+    auto val{q.try_get()};
+    ASSERT_TRUE(val.has_value());
+    EXPECT_EQ(*val, i);
+  }
+  EXPECT_FALSE(q.try_get().has_value());
+  // large buffers are released, only min sized ones are kept around
+  EXPECT_LT(q.allocated_bytes(), peak_bytes / 16);
+}
+TEST(MulticastRingTest, every_group_sees_every_entry_in_order) {
+  const int N = 100000;
+  multicast_ring<int> ring(64);
+  auto& first = ring.add_consumer_group();
+  auto& second = ring.add_consumer_group();
+  auto& last = ring.add_consumer_group({&first, &second});
+
+  auto run = [&](multicast_ring<int>::consumer_group& group, bool check_deps) {
+    std::int64_t expected = 0;
+    while (expected < N) {
+      group.consume([&](int& entry, std::int64_t seq) {
+        ASSERT_EQ(seq, expected);
+        ASSERT_EQ(entry, expected);
+        if (check_deps) {
+          ASSERT_GE(first.sequence(), seq);
+          ASSERT_GE(second.sequence(), seq);
+        }
+        expected++;
+      });
+    }
+  };
+  std::thread t1(run, std::ref(first), false);
+  std::thread t2(run, std::ref(second), false);
+  std::thread t3(run, std::ref(last), true);
+
+  for (int i = 0; i < N; i++) ring.put(i);
+  t1.join();
+  t2.join();
+  t3.join();
+  EXPECT_EQ(last.sequence(), N - 1);
+}
+
+TEST(WorkStealingDequeTest, owner_pops_newest_thieves_steal_oldest) {
+  work_stealing_deque<int> deque(2);
+  for (int i = 0; i < 10; i++) deque.push(i);
+  EXPECT_GE(deque.capacity(), 10u);
+  EXPECT_EQ(deque.pop(), 9);
+  EXPECT_EQ(deque.steal(), 0);
+  EXPECT_EQ(deque.size(), 8u);
+}
+
+TEST(WorkStealingDequeTest, every_item_taken_once) {
+  const int N = 200000;
+  const int thieves = 3;
+  work_stealing_deque<int> deque(16);
+  std::vector<std::atomic<int>> taken(N);
+  std::atomic<int> count{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thieves; t++) {
+    threads.emplace_back([&]() {
+      while (count.load() < N) {
+        if (auto item = deque.steal()) {
+          taken[*item]++;
+          count++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < N; i++) {
+    deque.push(i);
+    if (i % 3 == 0) {
+      if (auto item = deque.pop()) {
+        taken[*item]++;
+        count++;
+      }
+    }
+  }
+  while (auto item = deque.pop()) {
+    taken[*item]++;
+    count++;
+  }
+  for (auto& t : threads) t.join();
+
+  for (int i = 0; i < N; i++) ASSERT_EQ(taken[i].load(), 1) << i;
+}
+
+static std::int64_t fib_tasks(work_stealing_pool& pool, int n) {
+  if (n < 2) return n;
+  std::int64_t a{};
+  std::atomic<bool> done{false};
+  pool.submit([&]() {
+    a = fib_tasks(pool, n - 1);
+    done.store(true, std::memory_order::release);
+  });
+  const auto b = fib_tasks(pool, n - 2);
+  pool.wait_until([&]() { return done.load(std::memory_order::acquire); });
+  return a + b;
+}
+
+TEST(WorkStealingPoolTest, recursive_fib) {
+  work_stealing_pool pool(4);
+  EXPECT_EQ(fib_tasks(pool, 20), 6765);
+}
+
+TEST(HazardDomainTest, protected_node_survives_scan) {
+  struct tracked {
+    std::atomic<int>* deleted;
+    ~tracked() { (*deleted)++; }
+  };
+  std::atomic<int> deleted{0};
+  hazard_domain domain;
+  std::atomic<tracked*> shared{new tracked{&deleted}};
+
+  auto* guarded = domain.protect(0, shared);
+  shared.store(nullptr);
+  domain.retire(guarded);
+  // enough retirements to trigger a few scans
+  for (int i = 0; i < 1000; i++) domain.retire(new tracked{&deleted});
+  EXPECT_GE(deleted.load(), 900);
+  EXPECT_EQ(domain.pending(), 1000u + 1 - deleted.load());
+
+  domain.clear(0);
+  for (int i = 0; i < 1000; i++) domain.retire(new tracked{&deleted});
+  EXPECT_LT(domain.pending(), 1000u);
+}
+
+TEST(LockfreeQueueMsTest, variable_sized_messages) {
+  lockfree_queue_ms<std::string> q;
+  const int N = 20000;
+  std::thread producer([&]() {
+    for (int i = 0; i < N; i++) q.try_put(std::string(i % 200, 'x'));
+  });
+  int consumed = 0;
+  while (consumed < N) {
+    if (auto msg = q.try_get()) {
+      ASSERT_EQ(msg->size(), static_cast<std::size_t>(consumed % 200));
+      consumed++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+TEST(EpochDomainTest, reader_in_critical_section_holds_back_reclamation) {
+  struct tracked {
+    std::atomic<int>* deleted;
+    ~tracked() { (*deleted)++; }
+  };
+  std::atomic<int> deleted{0};
+  epoch_domain domain;
+
+  std::atomic<bool> entered{false}, leave{false};
+  std::thread reader([&]() {
+    epoch_domain::guard guard(domain);
+    entered = true;
+    while (!leave) std::this_thread::yield();
+  });
+  while (!entered) std::this_thread::yield();
+
+  for (int i = 0; i < 1000; i++) domain.retire(new tracked{&deleted});
+  EXPECT_EQ(deleted.load(), 0);
+  EXPECT_EQ(domain.pending(), 1000u);
+
+  leave = true;
+  reader.join();
+  domain.reclaim();
+  domain.reclaim();
+  EXPECT_EQ(deleted.load(), 1000);
+  EXPECT_EQ(domain.pending(), 0u);
+}
+
+TEST(EpochDomainTest, guards_nest) {
+  epoch_domain domain;
+  {
+    epoch_domain::guard outer(domain);
+    { epoch_domain::guard inner(domain); }
+    domain.retire(new int{1});
+    // still inside outer: the epoch can move at most once
+    for (int i = 0; i < 10; i++) domain.reclaim();
+    EXPECT_EQ(domain.pending(), 1u);
+  }
+  domain.reclaim();
+  domain.reclaim();
+  EXPECT_EQ(domain.pending(), 0u);
+}
+
+// pointer + tag, 12 bytes: fits a 16 byte slot next to the full flag
+struct __attribute__((packed)) tagged_ptr {
+  void* ptr;
+  std::uint32_t tag;
+};
+
+TEST(LockfreeQueueTest, sixteen_byte_slots) {
+  static_assert(!has_dwcas || lockfree_queue<tagged_ptr>::is_lock_free);
+  const int N = 20000;
+  lockfree_queue<tagged_ptr> q(1000);
+  std::vector<int> targets(N);
+  std::thread producer([&]() {
+    for (int i = 0; i < N; i++) {
+      while (!q.try_put({&targets[i], static_cast<std::uint32_t>(i)})) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int consumed = 0;
+  std::vector<bool> seen(N);
+  while (consumed < N) {
+    if (auto item = q.try_get()) {
+      ASSERT_EQ(item->ptr, &targets[item->tag]);
+      ASSERT_FALSE(seen[item->tag]);
+      seen[item->tag] = true;
+      consumed++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+}
+
+TEST(IntrusiveMpscQueueTest, producers_keep_their_order) {
+  struct message : mpsc_hook {
+    int producer;
+    int seq;
+  };
+  const int N = 20000;
+  const int producers = 3;
+  std::vector<std::vector<message>> messages(producers, std::vector<message>(N));
+  intrusive_mpsc_queue<message> q;
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(q.try_pop(), nullptr);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < N; i++) {
+        messages[p][i].producer = p;
+        messages[p][i].seq = i;
+        q.push(messages[p][i]);
+      }
+    });
+  }
+  std::vector<int> next(producers, 0);
+  int consumed = 0;
+  while (consumed < N * producers) {
+    if (auto* msg = q.try_pop()) {
+      ASSERT_EQ(msg, &messages[msg->producer][next[msg->producer]]);
+      next[msg->producer]++;
+      consumed++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& t : threads) t.join();
+  EXPECT_TRUE(q.empty());
+
+  // nodes can be pushed again once popped
+  q.push(messages[0][0]);
+  EXPECT_EQ(q.try_pop(), &messages[0][0]);
+  EXPECT_EQ(q.try_pop(), nullptr);
+}
+
+TEST(FlatCombiningQueueTest, more_threads_than_records) {
+  flat_combining_queue<int> q(1000);
+  const int threads = flat_combining_queue<int>::record_count + 16;
+  const int per_thread = 200;
+  std::atomic<long> sum{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      for (int i = 0; i < per_thread; i++) {
+        while (!q.try_put(t * per_thread + i)) std::this_thread::yield();
+        std::optional<int> val;
+        while (!(val = q.try_get())) std::this_thread::yield();
+        sum += *val;
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  const long n = threads * per_thread;
+  EXPECT_EQ(sum.load(), n * (n - 1) / 2);
+  EXPECT_FALSE(q.try_get().has_value());
+}
+
+template <typename T>
+class LockTest : public ::testing::Test {};
+
+using LockTypes = ::testing::Types<ttas_spinlock, ticket_lock, mcs_lock>;
+
+TYPED_TEST_SUITE(LockTest, LockTypes);
+
+TYPED_TEST(LockTest, mutual_exclusion) {
+  TypeParam lock;
+  const int threads = 8;
+  const int N = 20000;
+  long counter = 0;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&]() {
+      for (int i = 0; i < N; i++) {
+        std::lock_guard<TypeParam> guard(lock);
+        counter++;
+      }
+    });
+  }
+  for (auto& w : workers) w.join();
+  EXPECT_EQ(counter, static_cast<long>(threads) * N);
+  EXPECT_TRUE(lock.try_lock());
+  EXPECT_FALSE(lock.try_lock());
+  lock.unlock();
+}
+
+TEST(McsLockTest, release_out_of_order) {
+  mcs_lock a, b, c;
+  a.lock();
+  b.lock();
+  a.unlock();
+  c.lock();
+  std::thread other([&]() {
+    std::lock_guard<mcs_lock> guard(a);
+  });
+  other.join();
+  b.unlock();
+  c.unlock();
+  EXPECT_TRUE(b.try_lock());
+  b.unlock();
+}
+
+TEST(PhaseFairRwlockTest, writer_progresses_under_constant_readers) {
+  phase_fair_rwlock lock;
+  long a = 0, b = 0;
+  std::atomic<bool> done{false};
+  std::atomic<long> reads{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; r++) {
+    readers.emplace_back([&]() {
+      while (!done.load()) {
+        std::shared_lock<phase_fair_rwlock> guard(lock);
+        ASSERT_EQ(a, b);
+        reads++;
+      }
+    });
+  }
+  while (reads.load() < 100) std::this_thread::yield();
+  for (int i = 0; i < 1000; i++) {
+    std::lock_guard<phase_fair_rwlock> guard(lock);
+    a++;
+    b++;
+  }
+  done = true;
+  for (auto& r : readers) r.join();
+  EXPECT_EQ(a, 1000);
+  EXPECT_EQ(b, 1000);
+}
+
+TEST(BackoffTest, retry_with_waits_for_full_and_empty) {
+  lockfree_queue_fixed<int> q(4);
+  const int N = 2000;
+  std::thread producer([&]() {
+    for (int i = 0; i < N; i++)
+      retry_with<spin_yield_sleep_backoff>([&] { return q.try_put(i); });
+  });
+  for (int i = 0; i < N; i++) {
+    const auto val{retry_with<exponential_backoff>([&] { return q.try_get(); })};
+    ASSERT_EQ(*val, i);
+  }
+  producer.join();
+}
+
+TEST(MultiQueueTest, one_lane_is_fifo) {
+  multi_queue<int> q(100, 1);
+  for (int i = 0; i < 100; i++) ASSERT_TRUE(q.try_put(i));
+  EXPECT_FALSE(q.try_put(100));
+  for (int i = 0; i < 100; i++) EXPECT_EQ(q.try_get(), i);
+  EXPECT_FALSE(q.try_get().has_value());
+}
+
+TEST(MultiQueueTest, every_lane_is_used_and_drained) {
+  multi_queue<int> q(64, 8);
+  for (int i = 0; i < 64; i++) ASSERT_TRUE(q.try_put(i));
+  EXPECT_FALSE(q.try_put(64));
+  std::vector<bool> seen(64);
+  for (int i = 0; i < 64; i++) {
+    const auto val{q.try_get()};
+    ASSERT_TRUE(val.has_value());
+    EXPECT_FALSE(seen[*val]);
+    seen[*val] = true;
+  }
+  EXPECT_FALSE(q.try_get().has_value());
+}
+
+TEST(MultiPriorityQueueTest, one_lane_pops_in_priority_order) {
+  multi_priority_queue<int, int> q(100, 1);
+  for (int i = 0; i < 100; i++) q.push((i * 37) % 100, i);
+  for (int p = 0; p < 100; p++) {
+    const auto e{q.try_pop_min()};
+    ASSERT_TRUE(e.has_value());
+    EXPECT_EQ(e->first, p);
+    EXPECT_EQ((e->second * 37) % 100, p);
+  }
+  EXPECT_FALSE(q.try_pop_min().has_value());
+}
+
+TEST(MultiPriorityQueueTest, concurrent_push_and_bulk_pop) {
+  multi_priority_queue<std::uint64_t, int> q(10000, 8);
+  const int threads = 4;
+  const int N = 5000;
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threads; t++) {
+    producers.emplace_back([&, t]() {
+      for (int i = 0; i < N; i++) q.push(i, t * N + i);
+    });
+  }
+  std::vector<bool> seen(threads * N);
+  std::array<std::pair<std::uint64_t, int>, 16> batch;
+  int popped = 0;
+  while (popped < threads * N) {
+    const auto count{q.try_pop_min_bulk(batch)};
+    for (std::size_t i = 0; i < count; i++) {
+      if (i > 0) {
+        EXPECT_LE(batch[i - 1].first, batch[i].first);
+      }
+      ASSERT_FALSE(seen[batch[i].second]);
+      seen[batch[i].second] = true;
+    }
+    popped += count;
+    if (count == 0) std::this_thread::yield();
+  }
+  for (auto& p : producers) p.join();
+  EXPECT_FALSE(q.try_pop_min().has_value());
+}
+
+TEST(LockfreeQueueFixedTest, overwrite_oldest_keeps_the_newest) {
+  lockfree_queue_fixed<std::string, compact_layout, no_backoff,
+                       overwrite_oldest>
+      q(4);
+  for (int i = 0; i < 10; i++) ASSERT_TRUE(q.try_put(std::to_string(i)));
+  EXPECT_EQ(q.overruns(), 6u);
+  for (int i = 6; i < 10; i++) EXPECT_EQ(q.try_get(), std::to_string(i));
+  EXPECT_FALSE(q.try_get().has_value());
+}
+
+TEST(LockfreeQueueFixedTest, overwrite_oldest_skips_a_peeked_slot) {
+  lockfree_queue_fixed<int, compact_layout, no_backoff, overwrite_oldest> q(8);
+  for (int i = 0; i < 8; i++) ASSERT_TRUE(q.try_put(i));
+  auto read{q.try_peek()};
+  ASSERT_TRUE(read.has_value());
+  EXPECT_EQ(read->value(), 0);
+  // the writer's slot is held by the reader, the newer entries stay
+  std::thread producer([&]() { EXPECT_FALSE(q.try_put(8)); });
+  producer.join();
+  EXPECT_EQ(q.overruns(), 0u);
+  q.release(*read);
+
+  ASSERT_TRUE(q.try_put(8));
+  EXPECT_EQ(q.overruns(), 0u);
+  ASSERT_TRUE(q.try_put(9));
+  EXPECT_EQ(q.overruns(), 1u);
+  for (int i = 2; i < 10; i++) EXPECT_EQ(q.try_get(), i);
+  EXPECT_FALSE(q.try_get().has_value());
+}
+
+TEST(LockfreeQueueFixedTest, overwrite_oldest_with_slow_consumer) {
+  lockfree_queue_fixed<int, compact_layout, no_backoff, overwrite_oldest> q(
+      64);
+  const int producers = 4;
+  const int N = 20000;
+  std::atomic<int> done{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&, p]() {
+      // put: try_put fails if the consumer is preempted inside try_get
+      for (int i = 0; i < N; i++) q.put(p * N + i);
+      done++;
+    });
+  }
+  std::vector<int> last(producers, -1);
+  std::size_t consumed = 0;
+  while (true) {
+    const bool finished = done.load() == producers;
+    if (auto val = q.try_get()) {
+      // per producer order survives, only entries go missing
+      const int p = *val / N;
+      ASSERT_GT(*val, last[p]);
+      last[p] = *val;
+      consumed++;
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    } else if (finished) {
+      break;
+    }
+  }
+  for (auto& t : threads) t.join();
+  EXPECT_EQ(consumed + q.overruns(), static_cast<std::size_t>(producers) * N);
+  EXPECT_GT(q.overruns(), 0u);
+}